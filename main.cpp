@@ -1,5 +1,5 @@
 /*
-mousekeys.cpp
+main.cpp
 
 A single-file Windows C++ program that lets you control the system mouse cursor
 with the keyboard using smooth, physics-style movement (like the TouHou
@@ -7,10 +7,23 @@ Project), but moves the real OS cursor so you can interact with other apps and
 the desktop.
 
 Controls
-> Arrow keys or H, J, K, and L for movement
+> Arrow keys or H, J, K, and L for movement (numpad 8/2/4/6, and 7/9/1/3 for
+diagonals)
 > 'Z' for Left Click
 > 'X' for Right Click
-> Capslock On/Off for Enable/Disable respectively
+> Left Shift held for slow movement
+> Capslock On/Off for Enable/Disable respectively. While control is off, Caps
+Lock is a registered hotkey and the keyboard hook is removed, so Right Shift
+only turns control off; it no longer turns it on (see HOOK_FREE_WHEN_DISABLED)
+> 'C' toggles the crosshair and trail overlay, 'M' the magnifier lens (shown
+while Left Shift is held), 'G' target magnetism
+> 'F' enters hint mode: type a two-letter label to jump there (Left Shift + F
+also clicks); Escape or 'F' again cancels
+> Digits before a direction key move exactly that many pixels (e.g. "10l");
+any other key or Escape drops the count. Ctrl + direction jumps half the
+monitor (a quarter with Left Shift)
+> 'A' held locks movement to the dominant axis; 'S' held snaps the direction
+of motion (keys, glides, plugin motion) to multiples of ANGLE_SNAP_DEGREES
 
 Features
 - Global low-level keyboard hook (WH_KEYBOARD_LL) so you can control the cursor
@@ -30,301 +43,3530 @@ global hooks.
 delivered to other apps. Toggle with Capslock to return normal keyboard
 behavior.
 
-Build (MSVC): cl /EHsc /O2 mousekeys.cpp user32.lib gdi32.lib
+Build (MSVC): cl /std:c++17 /EHsc /O2 main.cpp /Fe:mousekeys.exe (the libraries
+are pulled in by the #pragma comment lines below)
 
-Build (MinGW): g++ -std=c++17 -O2 -mwindows mousekeys.cpp -lgdi32 -luser32 -o
-mousekeys.exe
+Build (MinGW): g++ -std=c++17 -O2 -mwindows main.cpp -lopengl32 -ldwmapi -lole32
+-loleaut32 -lpsapi -luser32 -lgdi32 -o mousekeys.exe
 */
 
 #define WIN32_LEAN_AND_MEAN
 #include <atomic>
+#include <charconv>
 #include <chrono>
 #include <thread>
+#include <climits>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include <windows.h>
+#include <GL/gl.h>
+#include <uiautomation.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MOUSEKEYS_SSE2 1
+#include <emmintrin.h>
+#endif
+#ifndef WDA_EXCLUDEFROMCAPTURE
+#define WDA_EXCLUDEFROMCAPTURE 0x00000011
+#endif
+#include <dwmapi.h>
+#include <psapi.h>
+#include "mousekeys_plugin.h"
+#ifdef _MSC_VER
+#pragma comment(lib, "opengl32.lib")
+#pragma comment(lib, "dwmapi.lib")
+#pragma comment(lib, "ole32.lib")
+#pragma comment(lib, "oleaut32.lib")
+#pragma comment(lib, "psapi.lib")
+#pragma comment(lib, "user32.lib")
+#pragma comment(lib, "gdi32.lib")
+#endif
 
 // --- Configuration (tweak to match feel) ---
 static constexpr float ACCEL_PIX_PER_S2 = 10000.0f; // ammount of acceleration when key held
 static constexpr float MAX_SPEED_PIX_PER_S = 700.0f; // top speed in pixels/sec
 static constexpr float FRICTION_PER_S = 1000.0f; // amount of friction
 static constexpr int UPDATES_PER_SEC = 120; // physics loop frequency
+static constexpr bool FIXED_POINT_POSITION = false; // held-key motion in 32.32 fixed point (see stepFixed)
+
+// Momentum: the cursor keeps gliding after the direction keys are released,
+// slowing as v(t) = v0 * exp(-GLIDE_FRICTION_PER_S * t), so a glide covers
+// v0 / GLIDE_FRICTION_PER_S pixels at any tick rate. Double-tapping a
+// direction within FLICK_WINDOW_MS flicks the cursor off at FLICK_SPEED_PIX_PER_S.
+static constexpr bool MOMENTUM = false;
+static constexpr double GLIDE_FRICTION_PER_S = 6.0;
+static constexpr double GLIDE_STOP_PIX_PER_S = 15.0; // glides slower than this stop dead
+static constexpr double FLICK_SPEED_PIX_PER_S = 6000.0;
+static constexpr uint32_t FLICK_WINDOW_MS = 250;
+
+// Per-application profiles, matched against the foreground window's executable
+// name (case-insensitive). Anything not listed uses DEFAULT_PROFILE.
+//
+// speedCurve optionally replaces maxSpeed with an expression of t, the seconds
+// a direction has been held, e.g. "min(700, 200 + 900*t^1.5)". Supported:
+// decimal numbers, t, + - * / ^, parentheses, min, max, clamp, sqrt, exp, abs.
+struct Profile {
+   const wchar_t *exeName;
+   float maxSpeed;  // top speed in pixels/sec
+   float slowMult;  // speed multiplier while Left Shift is held
+   const char *speedCurve; // nullptr = constant maxSpeed
+};
+static constexpr Profile DEFAULT_PROFILE = { L"", MAX_SPEED_PIX_PER_S, 0.5f, nullptr };
+static constexpr Profile PROFILES[] = {
+   { L"acad.exe",            350.0f, 0.25f, nullptr }, // CAD: fine placement matters more than travel
+   { L"blender.exe",         450.0f, 0.25f, nullptr },
+   { L"chrome.exe",          900.0f, 0.5f,  "min(900, 200 + 900*t^1.5)" }, // browsers: long hops between links
+   { L"firefox.exe",         900.0f, 0.5f,  "min(900, 200 + 900*t^1.5)" },
+   { L"WindowsTerminal.exe", 600.0f, 0.5f,  nullptr },
+};
+static constexpr int PROFILE_COUNT = 1 + sizeof(PROFILES) / sizeof(PROFILES[0]);
+
+// Index of a profile in [DEFAULT_PROFILE, PROFILES...], for per-profile runtime data
+static int profileIndex(const Profile *profile) {
+   return profile == &DEFAULT_PROFILE ? 0 : 1 + (int)(profile - PROFILES);
+}
+
+// Status HUD in the top-right corner of the primary monitor
+static constexpr bool SHOW_HUD = true;
+static constexpr int HUD_WIDTH = 168;
+static constexpr int HUD_HEIGHT = 44;
+static constexpr BYTE HUD_OPACITY = 210; // 0-255
+
+// Crosshair and fading motion trail around the cursor (toggle with 'C')
+static constexpr bool SHOW_OVERLAY = false; // initial state
+static constexpr int OVERLAY_SIZE = 320; // overlay window is a square centred on the cursor
+static constexpr int TRAIL_LENGTH = 48; // positions kept (one per physics tick)
+static constexpr float TRAIL_FADE_S = 0.35f; // seconds for a trail point to fade out
+
+// Magnifier lens shown next to the cursor while Left Shift is held (toggle with 'M')
+static constexpr bool SHOW_LENS = false; // initial state
+static constexpr int LENS_TILE = 32; // screen pixels captured around the cursor
+static constexpr int LENS_ZOOM = 8; // integer zoom factor
+static_assert(LENS_ZOOM > 0 && LENS_ZOOM % 4 == 0, "scaleNearest writes each zoomed pixel as 4-wide stores");
+static constexpr bool LENS_BILINEAR = false; // nearest-neighbour keeps pixel edges crisp
+static constexpr int LENS_MAX_FPS = 30; // refresh cap while the cursor moves
+
+// Target magnetism (toggle with 'G'): when no direction is held, the cursor
+// settles onto the centre of the nearest clickable element within range
+static constexpr bool SNAP_TO_TARGETS = false; // initial state
+static constexpr float SNAP_RADIUS_PX = 48.0f;
+static constexpr float SNAP_RATE_PER_S = 18.0f; // exponential approach rate
+static constexpr int TARGET_CELL_PX = 64; // spatial index cell size
+static constexpr int TARGET_MAX_W = 480; // larger elements (panes, lists) are not targets
+static constexpr int TARGET_MAX_H = 160;
+
+// Bullet time: while heading towards a target within range, speed scales down
+// linearly with distance to its centre, reaching BULLET_TIME_MIN_MULT on top
+static constexpr bool BULLET_TIME = false;
+static constexpr float BULLET_TIME_RADIUS_PX = 40.0f;
+static constexpr float BULLET_TIME_MIN_MULT = 0.3f;
+static_assert(BULLET_TIME_RADIUS_PX <= TARGET_CELL_PX, "keeps the per-tick query to at most 2x2 cells");
+
+// When UI Automation finds fewer targets than this (games, remote desktops),
+// targets are detected from a screenshot of the foreground window instead
+static constexpr bool VISION_FALLBACK = true;
+static constexpr size_t VISION_MIN_UIA_TARGETS = 3;
+static constexpr int VISION_EDGE_THRESHOLD = 96; // |gx| + |gy| of the 3x3 Sobel
+static constexpr int VISION_GAP_PX = 3; // edge gaps bridged so words join into one box
+
+// Hint mode (press 'F'): every target gets a two-letter label and typing one
+// warps there; entering with Left Shift held also clicks. Escape cancels.
+static constexpr const char HINT_ALPHABET[] = "asdjklghqweruiopzxcvbnmty"; // home row first, no 'f'
+
+// Metrics file in Prometheus text format, written next to the executable
+// (nullptr disables the exporter)
+static constexpr const wchar_t *METRICS_FILE_NAME = L"mousekeys.prom";
+static constexpr DWORD METRICS_INTERVAL_MS = 5000;
+
+// Drop the global keyboard hook while control is off and wake on a Caps Lock
+// hotkey instead, so typing pays nothing for the tool while it is disabled.
+// Right Shift then only turns control off.
+static constexpr bool HOOK_FREE_WHEN_DISABLED = true;
+
+// Moving the physical mouse while control is on: false = keyboard movement
+// carries on from wherever the mouse left the cursor, true = control turns off
+static constexpr bool MOUSE_SUSPENDS_CONTROL = false;
+
+// Local control endpoint (see controlLoop for the protocol)
+static constexpr const wchar_t *CONTROL_PIPE_NAME = L"\\\\.\\pipe\\mousekeys-control";
+
+// Soak mode (--soak <hours>) report, written next to the executable
+static constexpr const wchar_t *SOAK_REPORT_NAME = L"mousekeys-soak.txt";
+static constexpr long long SOAK_MAX_MEMORY_GROWTH = 1 << 20; // bytes, after the first virtual hour
 
 // Keys: movement keys and click keys
 static constexpr int LEFT_CLICK_KEY = 'Z';
 static constexpr int RIGHT_CLICK_KEY = 'X';
 
-// Key state storage (we'll track both arrow keys and WASD)
-std::atomic<bool> key_up(false), key_down(false), key_left(false), key_right(false);
-std::atomic<bool> key_k(false), key_h(false), key_j(false), key_l(false);
-std::atomic<bool> leftClickPressed(false), rightClickPressed(false);
-std::atomic<bool> shiftPressed(false);
+// Digits typed before a direction key move exactly that many pixels (10 l);
+// Ctrl + direction jumps half the current monitor (a quarter with Left Shift)
+static constexpr uint32_t NUDGE_MAX_COUNT = 9999;
+
+// --- Key bindings ---
+// Key bindings are resolved at compile time into ACTION_TABLE, so the hook does
+// one indexed load per keystroke instead of walking a switch. Startup still
+// does a little work before the hook goes in: compileProfileCurves parses the
+// profile speed curves into bytecode and lookup tables, and buildDirectionTable
+// fills the direction tables that physics and jumpCursor read.
+enum class Action : unsigned char {
+   None = 0,
+   Up,
+   Down,
+   Left,
+   Right,
+   LeftClick,
+   RightClick,
+   Slow,
+   Toggle,
+   ToggleOverlay,
+   ToggleLens,
+   ToggleMagnet,
+   Hint,
+   UpLeft,
+   UpRight,
+   DownLeft,
+   DownRight,
+   AxisLock,
+   AngleSnap,
+};
+
+static_assert((int)Action::Up == MK_ACTION_UP && (int)Action::AngleSnap == MK_ACTION_ANGLE_SNAP,
+   "Action values are part of the plugin ABI");
+
+struct Binding {
+   int vk;
+   Action action;
+};
+
+static constexpr Binding BINDINGS[] = {
+   { VK_UP,           Action::Up },
+   { 'K',             Action::Up },
+   { VK_DOWN,         Action::Down },
+   { 'J',             Action::Down },
+   { VK_LEFT,         Action::Left },
+   { 'H',             Action::Left },
+   { VK_RIGHT,        Action::Right },
+   { 'L',             Action::Right },
+   { LEFT_CLICK_KEY,  Action::LeftClick },
+   { RIGHT_CLICK_KEY, Action::RightClick },
+   { VK_LSHIFT,       Action::Slow },
+   { VK_RSHIFT,       Action::Toggle },
+   { VK_CAPITAL,      Action::Toggle },
+   { 'C',             Action::ToggleOverlay },
+   { 'M',             Action::ToggleLens },
+   { 'G',             Action::ToggleMagnet },
+   { 'F',             Action::Hint },
+   { VK_NUMPAD8,      Action::Up },
+   { VK_NUMPAD2,      Action::Down },
+   { VK_NUMPAD4,      Action::Left },
+   { VK_NUMPAD6,      Action::Right },
+   { VK_NUMPAD7,      Action::UpLeft },
+   { VK_NUMPAD9,      Action::UpRight },
+   { VK_NUMPAD1,      Action::DownLeft },
+   { VK_NUMPAD3,      Action::DownRight },
+   { 'A',             Action::AxisLock },
+   { 'S',             Action::AngleSnap },
+};
+static constexpr int BINDING_COUNT = sizeof(BINDINGS) / sizeof(BINDINGS[0]);
+
+// Direction actions and the angle each one moves in (degrees, counter-clockwise
+// from right). Any angle works, e.g. 22.5 degree steps for finer keys; each
+// entry is one bit of the held-direction mask, so there can be at most 8.
+// priority: wins against the opposite direction under Socd::Priority.
+struct DirectionSlot {
+   Action action;
+   double degrees;
+   bool priority;
+};
+
+static constexpr DirectionSlot DIRECTION_SLOTS[] = {
+   { Action::Right,       0.0, false },
+   { Action::UpRight,    45.0, false },
+   { Action::Up,         90.0, true },
+   { Action::UpLeft,    135.0, false },
+   { Action::Left,      180.0, false },
+   { Action::DownLeft,  225.0, false },
+   { Action::Down,      270.0, false },
+   { Action::DownRight, 315.0, false },
+};
+static constexpr int DIRECTION_SLOT_COUNT = sizeof(DIRECTION_SLOTS) / sizeof(DIRECTION_SLOTS[0]);
+static_assert(DIRECTION_SLOT_COUNT <= 8, "held directions are packed into one byte");
+
+// Opposite directions held together (SOCD): Neutral cancels them, LastWins
+// follows the newer press, FirstWins keeps the older one, Priority lets the
+// slot marked priority win (pairs with no priority slot cancel). Neutral is
+// the original behaviour; LastWins makes quick reversals take effect at once.
+enum class Socd { Neutral, LastWins, FirstWins, Priority };
+static constexpr Socd SOCD_POLICY = Socd::Neutral;
+
+// AngleSnap ('S' held) rotates each tick's motion onto the nearest multiple of
+// this many degrees, keeping its length. Single keys already sit on 45 degree
+// multiples; what it straightens is chords between them (Right + UpRight),
+// continuous motion (a glide after a flick, a motion plugin's path) and any
+// finer DIRECTION_SLOTS.
+static constexpr double ANGLE_SNAP_DEGREES = 45.0;
+static_assert(ANGLE_SNAP_DEGREES > 0.0, "snap step must be positive");
+
+// DIRECTION_SLOTS index for a direction action, -1 for anything else
+static constexpr int directionSlotOf(uint32_t action) {
+   for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+      if ((uint32_t)DIRECTION_SLOTS[s].action == action) return s;
+   }
+   return -1;
+}
+
+// Modifier actions physics checks every tick, as bits of the held-modifier mask
+static constexpr uint8_t HELD_SLOW = 1u << 0;
+static constexpr uint8_t HELD_LEFT_CLICK = 1u << 1;
+static constexpr uint8_t HELD_RIGHT_CLICK = 1u << 2;
+static constexpr uint8_t HELD_AXIS_LOCK = 1u << 3;
+static constexpr uint8_t HELD_ANGLE_SNAP = 1u << 4;
+
+static constexpr uint8_t heldBitOf(Action action) {
+   return action == Action::Slow ? HELD_SLOW
+      : action == Action::LeftClick ? HELD_LEFT_CLICK
+      : action == Action::RightClick ? HELD_RIGHT_CLICK
+      : action == Action::AxisLock ? HELD_AXIS_LOCK
+      : action == Action::AngleSnap ? HELD_ANGLE_SNAP : 0;
+}
+
+// Virtual-key code -> 1-based index into BINDINGS (0 = unbound), and binding ->
+// its bit in the held-direction mask (0 = not a direction) and in the
+// held-modifier mask (0 = not a modifier)
+struct ActionTable {
+   unsigned char bindingByVk[256];
+   unsigned char directionBit[BINDING_COUNT];
+   unsigned char modifierBit[BINDING_COUNT];
+};
+
+static constexpr ActionTable buildActionTable() {
+   ActionTable t = {};
+   for (int i = 0; i < BINDING_COUNT; ++i) {
+      t.bindingByVk[BINDINGS[i].vk & 0xFF] = (unsigned char)(i + 1);
+      t.modifierBit[i] = heldBitOf(BINDINGS[i].action);
+      for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+         if (DIRECTION_SLOTS[s].action == BINDINGS[i].action) t.directionBit[i] = (unsigned char)(1u << s);
+      }
+   }
+   return t;
+}
+static constexpr ActionTable ACTION_TABLE = buildActionTable();
+static_assert(BINDING_COUNT < 256, "binding index must fit the action table");
+
+// --- Engine state ---
+// Grouped by writer, each group on its own cache lines, so a burst of key
+// repeats on the hook thread never invalidates lines the physics thread is
+// writing, and vice versa. Readers on other threads only ever load.
+// MOUSEKEYS_PACKED_LAYOUT packs every group at natural alignment instead, as
+// the A/B baseline for the hook benchmark (bench_packed); never ship it.
+#ifdef MOUSEKEYS_PACKED_LAYOUT
+static constexpr size_t CACHE_LINE = alignof(std::max_align_t);
+#else
+static constexpr size_t CACHE_LINE = 64;
+#endif
+
+// Written only by the keyboard hook (main thread)
+struct alignas(CACHE_LINE) HookOwned {
+   std::atomic<bool> keyHeld[BINDING_COUNT]; // one flag per binding so e.g. Up and K can be held independently
+   std::atomic<uint8_t> directionMask{0}; // DIRECTION_SLOTS bits with at least one key held
+   std::atomic<uint8_t> modifierMask{0};  // HELD_* bits with at least one key held
+   
+   // Count prefix and jump state (never read off the hook thread, see jumpCursor)
+   uint32_t nudgeCount = 0; // digits typed so far
+   DWORD nudgeVk = 0;       // direction key that fired a jump, to swallow its repeats and release
+   bool ctrlHeld = false;
+   
+   // Hint mode keystrokes (see handleHintKey)
+   bool hintClick = false; // click once the hint's warp lands
+   int hintNode = 0;       // current trie node
+   DWORD hintLastVk = 0;   // last letter consumed, to ignore its auto-repeat
+   std::atomic<int> hintPrefix{-1}; // alphabet slot of the first letter typed, read by the UI
+};
+HookOwned g_hookOwned;
+
+struct TargetIndex;
+struct HintSet;
+
+// Written only by the physics thread
+struct alignas(CACHE_LINE) PhysicsOwned {
+   std::atomic<bool> prevLeft{false}, prevRight{false}; // buttons physics holds down (for drag/cleanup)
+   std::atomic<uint32_t> hudState{0}; // HUD_* bits, see publishHudState
+   std::atomic<const TargetIndex *> targetSeen{nullptr}; // index slot last picked up, see publishTargets
+   std::atomic<bool> parked{false}; // waiting on g_physicsWake, see wakePhysics
+};
+PhysicsOwned g_physicsOwned;
+
+// Controller and mode flags: written rarely (toggles, mode keys, control
+// pipe), read by every tick
+struct alignas(CACHE_LINE) ControlState {
+   std::atomic<LONGLONG> toggleTime{0}; // QPC time of the last enable/disable, for transition latency
+   std::atomic<bool> enabled{false};
+   std::atomic<bool> running{true};
+   std::atomic<bool> overlayOn{SHOW_OVERLAY};
+   std::atomic<bool> lensOn{SHOW_LENS};
+   std::atomic<bool> magnetOn{SNAP_TO_TARGETS};
+};
+ControlState g_control;
+
+// Written by the UI thread (others only clear idle, once, to wake it)
+struct alignas(CACHE_LINE) UiOwned {
+   std::atomic<DWORD> threadId{0};
+   std::atomic<bool> idle{true}; // parked and needs a wake-up post, see wakeUi
+   std::atomic<const HintSet *> hintsReading{nullptr}; // set being drawn, see publishHints
+};
+UiOwned g_uiOwned;
+
+// True if any key bound to the modifier with this HELD_* bit is held
+static bool modifierHeld(uint8_t bit) {
+   return (g_hookOwned.modifierMask.load(std::memory_order_relaxed) & bit) != 0;
+}
+
+// Re-derive the held masks after a direction or modifier key changed (hook thread)
+static void updateHeldMasks() {
+   uint8_t directions = 0, modifiers = 0;
+   for (int i = 0; i < BINDING_COUNT; ++i) {
+      if (!g_hookOwned.keyHeld[i].load(std::memory_order_relaxed)) continue;
+      directions |= ACTION_TABLE.directionBit[i];
+      modifiers |= ACTION_TABLE.modifierBit[i];
+   }
+   g_hookOwned.directionMask.store(directions, std::memory_order_relaxed);
+   g_hookOwned.modifierMask.store(modifiers, std::memory_order_relaxed);
+}
+
+// Forget every held key (hook thread), e.g. when releases can no longer be seen
+static void clearHeldKeys() {
+   for (int i = 0; i < BINDING_COUNT; ++i) g_hookOwned.keyHeld[i].store(false);
+   g_hookOwned.directionMask.store(0, std::memory_order_relaxed);
+   g_hookOwned.modifierMask.store(0, std::memory_order_relaxed);
+   g_hookOwned.nudgeCount = 0;
+   g_hookOwned.nudgeVk = 0;
+   g_hookOwned.ctrlHeld = false;
+}
+
+// Held-direction mask -> normalised direction, so physics resolves any number
+// of held direction keys with one load and one lookup. Opposing keys cancel.
+struct DirectionVector {
+   float x, y;
+};
+static DirectionVector g_directionTable[1 << DIRECTION_SLOT_COUNT];
+static DirectionVector g_snappedTable[1 << DIRECTION_SLOT_COUNT]; // same, snapped to ANGLE_SNAP_DEGREES (AngleSnap held)
+static int g_oppositeSlot[DIRECTION_SLOT_COUNT]; // slot 180 degrees away, -1 if none
+
+// Unit vector for an angle in screen space (y down). Multiples of 45 degrees
+// are built from sqrt alone, which is correctly rounded everywhere, so the
+// common table entries do not depend on the platform's sin/cos.
+static void directionUnit(double degrees, double &x, double &y) {
+   double octant = degrees / 45.0;
+   if (octant == std::floor(octant)) {
+      static const double h = std::sqrt(0.5);
+      static const double ux[8] = { 1.0, h, 0.0, -h, -1.0, -h, 0.0, h };
+      int i = ((int)octant % 8 + 8) % 8;
+      x = ux[i];
+      y = -ux[(i + 6) % 8]; // sin(a) = cos(a - 90)
+   } else {
+      double r = degrees * 3.14159265358979323846 / 180.0;
+      x = std::cos(r);
+      y = -std::sin(r);
+   }
+}
+
+// Nearest multiple of ANGLE_SNAP_DEGREES. Halves (chords of two adjacent keys)
+// round up, with some slack so atan2's last bit cannot flip them.
+static double snapAngle(double degrees) {
+   return std::floor(degrees / ANGLE_SNAP_DEGREES + 0.5 + 1e-9) * ANGLE_SNAP_DEGREES;
+}
+
+// Rotate (x, y) (screen space, y down) onto the nearest ANGLE_SNAP_DEGREES
+// multiple, keeping its length. A vector already on one is left bit-for-bit,
+// so snapped key motion keeps its sub-pixel and fixed-point state.
+static void snapVector(double &x, double &y) {
+   double len = std::sqrt(x * x + y * y);
+   if (len == 0.0) return;
+   double angle = std::atan2(-y, x) * 180.0 / 3.14159265358979323846;
+   double snapped = snapAngle(angle);
+   if (std::fabs(angle - snapped) < 1e-9) return;
+   directionUnit(snapped, x, y);
+   x *= len;
+   y *= len;
+}
+
+// Built once at startup, before the physics thread reads it
+static void buildDirectionTable() {
+   for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+      g_oppositeSlot[s] = -1;
+      for (int o = 0; o < DIRECTION_SLOT_COUNT; ++o) {
+         if (std::fmod(std::fabs(DIRECTION_SLOTS[s].degrees - DIRECTION_SLOTS[o].degrees), 360.0) == 180.0) g_oppositeSlot[s] = o;
+      }
+   }
+   for (int mask = 0; mask < (1 << DIRECTION_SLOT_COUNT); ++mask) {
+      double x = 0.0, y = 0.0;
+      for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+         if (!(mask & (1 << s))) continue;
+         double ux, uy;
+         directionUnit(DIRECTION_SLOTS[s].degrees, ux, uy);
+         x += ux;
+         y += uy;
+      }
+      double len = std::sqrt(x * x + y * y);
+      if (len < 1e-6) {
+         g_directionTable[mask] = g_snappedTable[mask] = DirectionVector{ 0.0f, 0.0f };
+         continue;
+      }
+      x /= len;
+      y /= len;
+      g_directionTable[mask] = DirectionVector{ (float)x, (float)y };
+      snapVector(x, y);
+      g_snappedTable[mask] = DirectionVector{ (float)x, (float)y };
+   }
+}
+
+// Single-producer/single-consumer ring. The hook thread pushes, the physics
+// thread drains; neither side ever blocks or allocates.
+template <typename T, uint32_t N>
+struct SpscRing {
+   static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+   T items[N];
+   alignas(CACHE_LINE) std::atomic<uint32_t> head{0}; // next slot to write (producer)
+   alignas(CACHE_LINE) std::atomic<uint32_t> tail{0}; // next slot to read (consumer)
+   
+   bool push(const T &item) {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == N) return false;
+      items[h & (N - 1)] = item;
+      head.store(h + 1, std::memory_order_release);
+      return true;
+   }
+   
+   uint32_t drain(T *out, uint32_t max) {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      uint32_t h = head.load(std::memory_order_acquire);
+      uint32_t n = 0;
+      for (; t != h && n < max; ++t, ++n) {
+         if (out) out[n] = items[t & (N - 1)];
+      }
+      tail.store(t, std::memory_order_release);
+      return n;
+   }
+};
+
+// Single-writer seqlock. The writer never waits; a reader retries only if a
+// publish overlapped its copy, so any number of readers get a consistent
+// value without locks. T is stored as relaxed atomic words so the racing
+// copy is well defined.
+template <typename T>
+struct SeqLock {
+   static_assert(std::is_trivially_copyable<T>::value, "seqlock values are copied bytewise");
+   static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+   alignas(CACHE_LINE) std::atomic<uint32_t> seq{0}; // odd while a publish is in progress
+   std::atomic<uint64_t> words[WORDS] = {};
+   
+   void publish(const T &value) {
+      uint64_t buf[WORDS] = {};
+      std::memcpy(buf, &value, sizeof(T));
+      uint32_t s = seq.load(std::memory_order_relaxed);
+      seq.store(s + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (size_t i = 0; i < WORDS; ++i) words[i].store(buf[i], std::memory_order_relaxed);
+      seq.store(s + 2, std::memory_order_release);
+   }
+   
+   T read() const {
+      uint64_t buf[WORDS];
+      uint32_t before, after;
+      do {
+         before = seq.load(std::memory_order_acquire);
+         for (size_t i = 0; i < WORDS; ++i) buf[i] = words[i].load(std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_acquire);
+         after = seq.load(std::memory_order_relaxed);
+      } while ((before & 1) || before != after);
+      T value;
+      std::memcpy(&value, buf, sizeof(T));
+      return value;
+   }
+};
+
+// Key transitions in arrival order, batched per tick for plugins
+static constexpr uint32_t KEY_EVENT_RING_SIZE = 256;
+SpscRing<mk_key_event, KEY_EVENT_RING_SIZE> g_keyEvents;
+
+// Low-level keyboard hook handle
+HHOOK g_hHook = nullptr;
+HHOOK g_mouseHook = nullptr; // low-level mouse hook, only while enabled
+
+// Signalled once at shutdown to wake the background service threads
+HANDLE g_shutdownEvent = nullptr;
+
+// QueryPerformanceCounter ticks per second
+LONGLONG g_qpcFrequency = 1;
+
+static LONGLONG qpcNow() {
+   LARGE_INTEGER t;
+   QueryPerformanceCounter(&t);
+   return t.QuadPart;
+}
+
+// Main (hook) thread id, so other threads can post requests to its message loop
+DWORD g_mainThreadId = 0;
+static constexpr UINT WM_APP_REINSTALL_HOOK = WM_APP + 1;
+static constexpr UINT WM_APP_SYNC_HOOK = WM_APP + 5; // enabled changed; install or drop the hook
+
+// Profile for the foreground application. Only replaced on focus changes; the
+// physics thread loads it once per tick.
+std::atomic<const Profile *> g_profile(&DEFAULT_PROFILE);
+
+// Fixed-bucket latency histogram. Bucket i counts samples <= BOUNDS_NS[i]; the
+// last bucket is the overflow (+Inf). Counts are not cumulative here.
+struct LatencyHistogram {
+   static constexpr int BUCKETS = 11;
+   static constexpr uint64_t BOUNDS_NS[BUCKETS - 1] = {
+      1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000,
+   };
+   std::atomic<uint64_t> counts[BUCKETS] = {};
+   std::atomic<uint64_t> sumNs{0};
+   
+   void record(uint64_t ns) {
+      int i = 0;
+      while (i < BUCKETS - 1 && ns > BOUNDS_NS[i]) ++i;
+      counts[i].fetch_add(1, std::memory_order_relaxed);
+      sumNs.fetch_add(ns, std::memory_order_relaxed);
+   }
+};
+
+// Engine counters. Writers use relaxed increments; readers (control pipe,
+// metrics exporter) only ever take snapshots, so nothing here is on a lock.
+// Counters are grouped by writing thread, one cache-line-aligned group each.
+struct EngineStats {
+   // Physics thread
+   alignas(CACHE_LINE) std::atomic<uint64_t> ticks{0};
+   std::atomic<uint64_t> tickOverruns{0}; // ticks that started more than a period late
+   std::atomic<uint64_t> injectedEvents{0};
+   // Whichever thread toggles: hook, hotkey (main thread) or control pipe
+   alignas(CACHE_LINE) std::atomic<uint64_t> toggles{0};
+   // Main thread (hook, hook lifetime)
+   alignas(CACHE_LINE) std::atomic<uint64_t> hookReinstalls{0};
+   std::atomic<uint64_t> droppedKeyEvents{0}; // key events lost to a full ring
+   LatencyHistogram hookLatency; // time spent inside the keyboard hook
+   LatencyHistogram hookTransition; // enable/disable until the hook is installed/removed
+};
+EngineStats g_stats;
+
+// Cursor positions handed to the physics thread, which takes each one with an
+// exchange of its flag. Positions are packed into one word (x << 32 | y).
+struct CursorRequests {
+   // Absolute warp (control pipe, hint mode, jumps)
+   alignas(CACHE_LINE) std::atomic<uint64_t> warpTarget{0};
+   std::atomic<bool> warpPending{false};
+   std::atomic<bool> warpClick{false}; // left click once the warp has landed
+   // Last physical mouse position (mouse hook), on its own line as it moves often
+   alignas(CACHE_LINE) std::atomic<uint64_t> physicalPos{0};
+   std::atomic<bool> physicalMoved{false};
+};
+CursorRequests g_cursorRequests;
+
+// Physics parks on this (auto-reset) event while control is off or nothing is
+// moving; toggles, key events, warps, new targets and shutdown set it
+HANDLE g_physicsWake = nullptr;
+
+// Wake the physics thread if it is parked. Call after publishing the work it
+// should see; the fence pairs with the one physicsLoop issues before waiting.
+static void wakePhysics() {
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (g_physicsOwned.parked.load(std::memory_order_relaxed) && g_physicsWake) SetEvent(g_physicsWake);
+}
+
+void requestWarp(int x, int y, bool click = false) {
+   g_cursorRequests.warpClick.store(click);
+   g_cursorRequests.warpTarget.store(((uint64_t)(uint32_t)x << 32) | (uint32_t)y);
+   g_cursorRequests.warpPending.store(true);
+   if (g_physicsWake) SetEvent(g_physicsWake);
+}
+
+// What the HUD shows, packed into one word. The physics thread is the only
+// writer; when the value changes it posts WM_APP_HUD_CHANGED to the UI thread,
+// so the HUD never polls and never redraws an unchanged frame.
+static constexpr uint32_t HUD_ENABLED = 1u << 0;
+static constexpr uint32_t HUD_SLOW = 1u << 1;
+static constexpr uint32_t HUD_LEFT_HELD = 1u << 2;
+static constexpr uint32_t HUD_RIGHT_HELD = 1u << 3;
+static constexpr UINT WM_APP_HUD_CHANGED = WM_APP + 2;
+static constexpr UINT WM_APP_UI_WAKE = WM_APP + 3;
+static constexpr UINT WM_APP_HINTS_CHANGED = WM_APP + 4;
+
+// What observers (HUD, control pipe, metrics) see of the engine. Published by
+// the physics thread at the end of every tick.
+struct EngineSnapshot {
+   uint64_t tick;
+   double x, y;   // sub-pixel cursor position
+   float vx, vy;  // pixels/sec over the last tick
+   uint32_t hud;  // HUD_* bits: enabled, slow, buttons held
+};
+SeqLock<EngineSnapshot> g_snapshot;
+
+void publishHudState(uint32_t state) {
+   if (state == g_physicsOwned.hudState.load(std::memory_order_relaxed)) return;
+   g_physicsOwned.hudState.store(state, std::memory_order_relaxed);
+   DWORD ui = g_uiOwned.threadId.load();
+   if (ui) PostThreadMessageW(ui, WM_APP_HUD_CHANGED, 0, 0);
+}
+
+// Recent cursor positions for the overlay trail. The physics thread pushes one
+// per tick while moving; if the UI thread falls behind, points are dropped
+// rather than ever making physics wait.
+struct TrailPoint {
+   float x, y;
+   LONGLONG time; // QPC ticks
+};
+static constexpr uint32_t TRAIL_RING_SIZE = 64;
+SpscRing<TrailPoint, TRAIL_RING_SIZE> g_trailRing;
+
+void wakeUi() {
+   if (g_uiOwned.idle.load(std::memory_order_relaxed) && g_uiOwned.idle.exchange(false)) {
+      DWORD ui = g_uiOwned.threadId.load();
+      if (ui) PostThreadMessageW(ui, WM_APP_UI_WAKE, 0, 0);
+   }
+}
+
+// --- Click targets ---
+// Screen rectangles of clickable elements in the foreground window, bucketed
+// by the uniform grid cell containing each centre. An index is built off the
+// physics thread and then only read, so queries never lock or allocate.
+struct TargetIndex {
+   int originX = 0, originY = 0; // top-left of cell (0, 0) in screen pixels
+   int cols = 0, rows = 0;
+   std::vector<RECT> rects;
+   std::vector<uint32_t> cellStart; // cols * rows + 1 offsets into cellItems
+   std::vector<uint32_t> cellItems; // rect indices grouped by cell
+};
+
+// Two index slots: one published to the physics thread (g_targetOwned.index),
+// one being rebuilt. The physics thread acknowledges the pointer it loaded in
+// targetSeen, so the builder knows when the spare slot is free to reuse.
+TargetIndex g_targetSlots[2];
+HANDLE g_targetsDirty = nullptr; // auto-reset; set on focus changes
+
+// Hint mode. The hook moves OFF -> PENDING (and anything -> OFF); the target
+// thread publishes a fresh hint set and moves PENDING -> ACTIVE. The hook only
+// reads the set while ACTIVE; the UI pins the set it draws (see publishHints).
+enum HintMode : int { HINT_OFF, HINT_PENDING, HINT_ACTIVE };
+std::atomic<int> g_hintMode(HINT_OFF);
+
+// Whether anything currently needs the target index
+static bool targetsWanted() {
+   return BULLET_TIME || g_control.magnetOn.load(std::memory_order_relaxed) || g_hintMode.load() == HINT_PENDING;
+}
+
+// Asks the target thread to rebuild the index for the foreground window
+void invalidateTargets() {
+   if (g_targetsDirty && targetsWanted()) SetEvent(g_targetsDirty);
+}
+
+// Fills an index from a list of rectangles (counting sort into grid cells)
+void buildTargetIndex(TargetIndex &index, const std::vector<RECT> &rects) {
+   index.rects.clear();
+   for (const RECT &r : rects) {
+      int w = r.right - r.left, h = r.bottom - r.top;
+      if (w > 0 && h > 0 && w <= TARGET_MAX_W && h <= TARGET_MAX_H) index.rects.push_back(r);
+   }
+   
+   int vx = GetSystemMetrics(SM_XVIRTUALSCREEN), vy = GetSystemMetrics(SM_YVIRTUALSCREEN);
+   int vw = GetSystemMetrics(SM_CXVIRTUALSCREEN), vh = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+   index.originX = vx;
+   index.originY = vy;
+   index.cols = vw / TARGET_CELL_PX + 1;
+   index.rows = vh / TARGET_CELL_PX + 1;
+   
+   auto cellOf = [&](const RECT &r) {
+      int cx = ((r.left + r.right) / 2 - index.originX) / TARGET_CELL_PX;
+      int cy = ((r.top + r.bottom) / 2 - index.originY) / TARGET_CELL_PX;
+      cx = cx < 0 ? 0 : (cx >= index.cols ? index.cols - 1 : cx);
+      cy = cy < 0 ? 0 : (cy >= index.rows ? index.rows - 1 : cy);
+      return cy * index.cols + cx;
+   };
+   
+   index.cellStart.assign((size_t)index.cols * index.rows + 1, 0);
+   for (const RECT &r : index.rects) ++index.cellStart[cellOf(r) + 1];
+   for (size_t i = 1; i < index.cellStart.size(); ++i) index.cellStart[i] += index.cellStart[i - 1];
+   
+   index.cellItems.resize(index.rects.size());
+   std::vector<uint32_t> fill(index.cellStart.begin(), index.cellStart.end() - 1);
+   for (uint32_t i = 0; i < (uint32_t)index.rects.size(); ++i) {
+      index.cellItems[fill[cellOf(index.rects[i])]++] = i;
+   }
+}
+
+// Nearest target centre within radius of (x, y), or -1. Only visits the few
+// cells overlapping the search box.
+int nearestTarget(const TargetIndex &index, double x, double y, double radius) {
+   if (index.rects.empty()) return -1;
+   int c0 = (int)std::floor((x - radius - index.originX) / TARGET_CELL_PX);
+   int c1 = (int)std::floor((x + radius - index.originX) / TARGET_CELL_PX);
+   int r0 = (int)std::floor((y - radius - index.originY) / TARGET_CELL_PX);
+   int r1 = (int)std::floor((y + radius - index.originY) / TARGET_CELL_PX);
+   // Clamp both ends: targets centred off the desktop live in the edge cells
+   auto clampTo = [](int v, int n) { return v < 0 ? 0 : (v >= n ? n - 1 : v); };
+   c0 = clampTo(c0, index.cols);
+   c1 = clampTo(c1, index.cols);
+   r0 = clampTo(r0, index.rows);
+   r1 = clampTo(r1, index.rows);
+   
+   int best = -1;
+   double bestDist2 = radius * radius;
+   for (int row = r0; row <= r1; ++row) {
+      for (int col = c0; col <= c1; ++col) {
+         int cell = row * index.cols + col;
+         for (uint32_t i = index.cellStart[cell]; i < index.cellStart[cell + 1]; ++i) {
+            const RECT &r = index.rects[index.cellItems[i]];
+            double ddx = (r.left + r.right) * 0.5 - x;
+            double ddy = (r.top + r.bottom) * 0.5 - y;
+            double d2 = ddx * ddx + ddy * ddy;
+            if (d2 <= bestDist2) {
+               bestDist2 = d2;
+               best = (int)index.cellItems[i];
+            }
+         }
+      }
+   }
+   return best;
+}
+
+// --- Hint labels ---
+// Labels are two letters, assigned in one pass over the index's cell order so
+// neighbouring targets share a first letter. Typed letters walk a two-level
+// trie: the root's children are one node per first letter, whose children
+// are targets.
+static constexpr int HINT_LETTERS = sizeof(HINT_ALPHABET) - 1;
+static constexpr int MAX_HINTS = HINT_LETTERS * HINT_LETTERS;
+
+struct HintNode {
+   int16_t next[HINT_LETTERS]; // 0 = no label, > 0 = node index, < 0 = ~target
+};
+
+struct HintSet {
+   int count = 0;
+   RECT rects[MAX_HINTS];
+   char labels[MAX_HINTS][3];
+   HintNode nodes[1 + HINT_LETTERS]; // [0] is the root
+};
+
+// 'A'..'Z' -> position in HINT_ALPHABET (-1 = not a label letter)
+struct HintSlots {
+   signed char byLetter[26];
+};
+
+static constexpr HintSlots buildHintSlots() {
+   HintSlots t = {};
+   for (int i = 0; i < 26; ++i) t.byLetter[i] = -1;
+   for (int i = 0; i < HINT_LETTERS; ++i) t.byLetter[HINT_ALPHABET[i] - 'a'] = (signed char)i;
+   return t;
+}
+static constexpr HintSlots HINT_SLOTS = buildHintSlots();
+static_assert(MAX_HINTS < 32768, "trie entries are 16-bit");
+
+// Double-buffered like the target index: the target thread fills the spare
+// slot and publishes it. The UI marks the set it is drawing (g_uiOwned) and
+// the builder waits for it to let go before reusing that slot, so a quick
+// Esc, F never rewrites labels mid-draw.
+HintSet g_hintSlots[2];
+
+// Written only by the target thread: the published index and hint set
+struct alignas(CACHE_LINE) TargetOwned {
+   std::atomic<const TargetIndex *> index{&g_targetSlots[0]};
+   std::atomic<const HintSet *> hints{&g_hintSlots[0]};
+};
+TargetOwned g_targetOwned;
+
+static void notifyHints() {
+   DWORD ui = g_uiOwned.threadId.load();
+   if (ui) PostThreadMessageW(ui, WM_APP_HINTS_CHANGED, 0, 0);
+}
+
+// Labels every target in the index (target thread, while PENDING)
+static void buildHints(const TargetIndex &index, HintSet &set) {
+   std::memset(set.nodes, 0, sizeof(set.nodes));
+   int n = 0;
+   for (uint32_t item : index.cellItems) {
+      if (n == MAX_HINTS) break;
+      int first = n / HINT_LETTERS, second = n % HINT_LETTERS;
+      set.rects[n] = index.rects[item];
+      set.labels[n][0] = HINT_ALPHABET[first];
+      set.labels[n][1] = HINT_ALPHABET[second];
+      set.labels[n][2] = 0;
+      set.nodes[0].next[first] = (int16_t)(first + 1);
+      set.nodes[first + 1].next[second] = (int16_t)~n;
+      ++n;
+   }
+   set.count = n;
+}
+
+// Labels the index into the spare set and publishes it (target thread)
+static const HintSet &publishHints(const TargetIndex &index) {
+   const HintSet *current = g_targetOwned.hints.load();
+   HintSet &spare = (current == &g_hintSlots[0]) ? g_hintSlots[1] : g_hintSlots[0];
+   while (g_uiOwned.hintsReading.load() == &spare) {
+      if (WaitForSingleObject(g_shutdownEvent, 1) == WAIT_OBJECT_0) return *current;
+   }
+   buildHints(index, spare);
+   g_targetOwned.hints.store(&spare);
+   return spare;
+}
+
+void cancelHints() {
+   if (g_hintMode.exchange(HINT_OFF) != HINT_OFF) notifyHints();
+}
+
+// Hook thread: asks the target thread for a fresh index to label
+static void enterHints(bool click) {
+   g_hookOwned.hintClick = click;
+   g_hookOwned.hintNode = 0;
+   g_hookOwned.hintPrefix.store(-1);
+   g_hintMode.store(HINT_PENDING);
+   invalidateTargets();
+}
+
+void setEnabled(bool on) {
+   if (g_control.enabled.exchange(on) != on) {
+      g_stats.toggles.fetch_add(1, std::memory_order_relaxed);
+      if (on) invalidateTargets(); // the page may have changed while we were off
+      else cancelHints();
+      
+      // The main thread owns the hooks and installs or drops them to match
+      g_control.toggleTime.store(qpcNow(), std::memory_order_relaxed);
+      if (g_mainThreadId) PostThreadMessageW(g_mainThreadId, WM_APP_SYNC_HOOK, 0, 0);
+      if (g_physicsWake) SetEvent(g_physicsWake); // also refreshes the HUD if physics is idle
+   }
+}
+
+// Utility: send a mouse click (left or right). Single click: down then up.
+void sendMouseClick(bool left) {
+   INPUT inputs[2] = {};
+   ZeroMemory(inputs, sizeof(inputs));
+   inputs[0].type = INPUT_MOUSE;
+   inputs[1].type = INPUT_MOUSE;
+   if (left) {
+      inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
+      inputs[1].mi.dwFlags = MOUSEEVENTF_LEFTUP;
+   } else {
+      inputs[0].mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
+      inputs[1].mi.dwFlags = MOUSEEVENTF_RIGHTUP;
+   }
+   SendInput(2, inputs, sizeof(INPUT));
+   g_stats.injectedEvents.fetch_add(2, std::memory_order_relaxed);
+}
+
+void sendMouseDown(bool left) {
+   INPUT input = {};
+   input.type = INPUT_MOUSE;
+   input.mi.dwFlags = left ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_RIGHTDOWN;
+   SendInput(1, &input, sizeof(INPUT));
+   g_stats.injectedEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+void sendMouseUp(bool left) {
+   INPUT input = {};
+   input.type = INPUT_MOUSE;
+   input.mi.dwFlags = left ? MOUSEEVENTF_LEFTUP : MOUSEEVENTF_RIGHTUP;
+   SendInput(1, &input, sizeof(INPUT));
+   g_stats.injectedEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Feeds one key press to hint mode. Returns true if it was consumed.
+static bool handleHintKey(DWORD vk) {
+   if (vk == VK_ESCAPE) {
+      cancelHints();
+      return true;
+   }
+   int slot = (vk >= 'A' && vk <= 'Z') ? HINT_SLOTS.byLetter[vk - 'A'] : -1;
+   if (slot < 0) return false; // 'F' (cancel) and other keys take the normal path
+   if (vk == g_hookOwned.hintLastVk || g_hintMode.load() != HINT_ACTIVE) return true;
+   g_hookOwned.hintLastVk = vk;
+   
+   const HintSet &hints = *g_targetOwned.hints.load();
+   int next = hints.nodes[g_hookOwned.hintNode].next[slot];
+   if (next > 0) {
+      g_hookOwned.hintNode = next;
+      g_hookOwned.hintPrefix.store(slot);
+      notifyHints();
+   } else if (next < 0) {
+      const RECT &r = hints.rects[~next];
+      requestWarp((r.left + r.right) / 2, (r.top + r.bottom) / 2, g_hookOwned.hintClick);
+      cancelHints();
+   }
+   return true; // letters that match no label are ignored
+}
+
+// Count nudge or Ctrl jump for a direction key (hook thread): one absolute
+// warp from where the cursor is, or already headed if a warp is pending. The
+// step is scaled so its larger axis is exactly count pixels (or the monitor
+// fraction), so diagonals move N pixels on both axes.
+static void jumpCursor(uint8_t dirBit, uint32_t count) {
+   double x, y;
+   if (g_cursorRequests.warpPending.load()) {
+      uint64_t target = g_cursorRequests.warpTarget.load();
+      x = (double)(int32_t)(uint32_t)(target >> 32);
+      y = (double)(int32_t)(uint32_t)target;
+   } else {
+      EngineSnapshot snap = g_snapshot.read();
+      x = std::round(snap.x);
+      y = std::round(snap.y);
+   }
+   
+   const DirectionVector &dir = g_directionTable[dirBit];
+   double ax = std::fabs(dir.x), ay = std::fabs(dir.y);
+   double unitX = dir.x / (ax > ay ? ax : ay), unitY = dir.y / (ax > ay ? ax : ay);
+   double stepX = count, stepY = count;
+   if (!count) {
+      MONITORINFO mi = {};
+      mi.cbSize = sizeof(mi);
+      POINT pt = { (LONG)x, (LONG)y };
+      GetMonitorInfoW(MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST), &mi);
+      double frac = modifierHeld(HELD_SLOW) ? 0.25 : 0.5;
+      stepX = (mi.rcMonitor.right - mi.rcMonitor.left) * frac;
+      stepY = (mi.rcMonitor.bottom - mi.rcMonitor.top) * frac;
+   }
+   x += std::round(unitX * stepX);
+   y += std::round(unitY * stepY);
+   
+   // Same bounds physics clamps to
+   int screenW = GetSystemMetrics(SM_CXSCREEN), screenH = GetSystemMetrics(SM_CYSCREEN);
+   x = (x < 0.0) ? 0.0 : (x > screenW - 1) ? screenW - 1 : x;
+   y = (y < 0.0) ? 0.0 : (y > screenH - 1) ? screenH - 1 : y;
+   requestWarp((int)x, (int)y);
+}
+
+// dwExtraInfo of keys we inject ourselves, so the hook lets them through
+static constexpr ULONG_PTR INJECTED_KEY_TAG = 0x4D4B4559; // 'MKEY'
+
+// Keyboard hook body (see LowLevelKeyboardProc)
+static LRESULT handleKeyboardHook(int nCode, WPARAM wParam, LPARAM lParam) {
+   if (nCode < 0) {
+      return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+   }
+   
+   KBDLLHOOKSTRUCT *kb = reinterpret_cast<KBDLLHOOKSTRUCT *>(lParam);
+   if (kb->dwExtraInfo == INJECTED_KEY_TAG) {
+      return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+   }
+   bool isDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+   bool isUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
+   
+   // Hint mode takes presses first; releases still go through below so held state clears
+   if (isUp && kb->vkCode == g_hookOwned.hintLastVk) g_hookOwned.hintLastVk = 0;
+   if (isDown && g_hintMode.load() != HINT_OFF && handleHintKey(kb->vkCode)) return 1;
+   
+   // Count prefixes and jumps: swallow the rest of a press that jumped, collect
+   // digits while enabled, and let Escape drop a half-typed count
+   if (kb->vkCode == VK_LCONTROL || kb->vkCode == VK_RCONTROL) g_hookOwned.ctrlHeld = isDown;
+   if (kb->vkCode == g_hookOwned.nudgeVk) {
+      if (isUp) g_hookOwned.nudgeVk = 0;
+      return 1;
+   }
+   if (g_control.enabled.load()) {
+      if (kb->vkCode >= '0' && kb->vkCode <= '9') {
+         if (isDown) {
+            uint32_t count = g_hookOwned.nudgeCount * 10 + (kb->vkCode - '0');
+            g_hookOwned.nudgeCount = (count > NUDGE_MAX_COUNT) ? NUDGE_MAX_COUNT : count;
+         }
+         return 1;
+      }
+      if (isDown && kb->vkCode == VK_ESCAPE && g_hookOwned.nudgeCount) {
+         g_hookOwned.nudgeCount = 0;
+         return 1;
+      }
+   }
+   
+   int binding = (kb->vkCode < 256) ? ACTION_TABLE.bindingByVk[kb->vkCode] - 1 : -1;
+   if (binding < 0) {
+      if (isDown) g_hookOwned.nudgeCount = 0; // any other key drops a pending count
+      return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+   }
+   Action action = BINDINGS[binding].action;
+   
+   // Toggle on key down of Right Shift or Caps Lock
+   if (action == Action::Toggle) {
+      if (isDown) {
+         setEnabled(!g_control.enabled.load());
+         
+         return 1;
+      }
+   } else if (g_control.enabled.load()) {
+      // Mode keys act once per press, not on auto-repeat
+      if (isDown && !g_hookOwned.keyHeld[binding].load()) {
+         uint8_t dirBit = ACTION_TABLE.directionBit[binding];
+         if (dirBit && (g_hookOwned.nudgeCount || g_hookOwned.ctrlHeld)) {
+            jumpCursor(dirBit, g_hookOwned.nudgeCount);
+            g_hookOwned.nudgeCount = 0;
+            g_hookOwned.nudgeVk = kb->vkCode;
+            return 1;
+         }
+         g_hookOwned.nudgeCount = 0; // a count only applies to the very next key
+         
+         if (action == Action::ToggleOverlay) {
+            g_control.overlayOn.store(!g_control.overlayOn.load());
+            wakeUi();
+         } else if (action == Action::ToggleLens) {
+            g_control.lensOn.store(!g_control.lensOn.load());
+            wakeUi();
+         } else if (action == Action::ToggleMagnet) {
+            g_control.magnetOn.store(!g_control.magnetOn.load());
+            invalidateTargets();
+         } else if (action == Action::Hint) {
+            if (g_hintMode.load() == HINT_OFF) enterHints(modifierHeld(HELD_SLOW));
+            else cancelHints();
+         }
+      }
+      
+      // Update our internal key state and swallow movement keys and click keys
+      if (isDown) g_hookOwned.keyHeld[binding].store(true);
+      if (isUp) g_hookOwned.keyHeld[binding].store(false);
+      if (ACTION_TABLE.directionBit[binding] || ACTION_TABLE.modifierBit[binding]) updateHeldMasks();
+      if (isDown || isUp) {
+         if (!g_keyEvents.push({ (uint32_t)kb->vkCode, (uint32_t)action, isDown ? 1u : 0u, (uint32_t)kb->time })) {
+            g_stats.droppedKeyEvents.fetch_add(1, std::memory_order_relaxed);
+         }
+         wakePhysics();
+      }
+      return 1; // swallow when enabled
+   } else {
+      // Releases are not seen while disabled, so forget everything (click keys
+      // included, or a drag would resume on the next enable)
+      clearHeldKeys();
+   }
+   
+   // If not enabled, or other keys, pass through
+   return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+}
+
+// --- Speed curves ---
+// Profile curves are compiled once at startup into a small register bytecode.
+// A curve can only depend on t, so the ramp-up section [0, CURVE_LUT_SPAN_S] is
+// pre-sampled into a lookup table and the tick just interpolates; past the
+// table the bytecode runs directly. Neither path allocates. Curves that go
+// negative during ramp-up are rejected, and every sample (past the table too)
+// is clamped to [0, CURVE_MAX_SPEED].
+static constexpr int CURVE_MAX_CODE = 64;
+static constexpr int CURVE_MAX_CONSTS = 16;
+static constexpr int CURVE_MAX_REGS = 16;
+static constexpr int CURVE_LUT_SIZE = 256;
+static constexpr float CURVE_LUT_SPAN_S = 2.0f;
+static constexpr float CURVE_MAX_SPEED = 20000.0f; // pixels/sec
+
+enum CurveOp : uint8_t {
+   CURVE_CONST, // r[dst] = k[a]
+   CURVE_T,     // r[dst] = t
+   CURVE_ADD, CURVE_SUB, CURVE_MUL, CURVE_DIV, CURVE_POW, CURVE_MIN, CURVE_MAX, // r[dst] = r[a] op r[b]
+   CURVE_NEG, CURVE_SQRT, CURVE_EXP, CURVE_ABS, // r[dst] = op r[a]
+};
+
+struct CurveInstr {
+   uint8_t op, dst, a, b;
+};
+
+struct SpeedCurve {
+   bool valid = false;
+   int codeLen = 0;
+   int result = 0; // register holding the final value
+   CurveInstr code[CURVE_MAX_CODE];
+   float consts[CURVE_MAX_CONSTS];
+   float lut[CURVE_LUT_SIZE + 1];
+};
+
+SpeedCurve g_curves[PROFILE_COUNT];
+
+// Runs the bytecode for one value of t
+static float evalCurve(const SpeedCurve &curve, float t) {
+   float r[CURVE_MAX_REGS];
+   for (int i = 0; i < curve.codeLen; ++i) {
+      const CurveInstr &in = curve.code[i];
+      switch (in.op) {
+         case CURVE_CONST: r[in.dst] = curve.consts[in.a]; break;
+         case CURVE_T:     r[in.dst] = t; break;
+         case CURVE_ADD:   r[in.dst] = r[in.a] + r[in.b]; break;
+         case CURVE_SUB:   r[in.dst] = r[in.a] - r[in.b]; break;
+         case CURVE_MUL:   r[in.dst] = r[in.a] * r[in.b]; break;
+         case CURVE_DIV:   r[in.dst] = r[in.a] / r[in.b]; break;
+         case CURVE_POW:   r[in.dst] = std::pow(r[in.a], r[in.b]); break;
+         case CURVE_MIN:   r[in.dst] = std::fmin(r[in.a], r[in.b]); break;
+         case CURVE_MAX:   r[in.dst] = std::fmax(r[in.a], r[in.b]); break;
+         case CURVE_NEG:   r[in.dst] = -r[in.a]; break;
+         case CURVE_SQRT:  r[in.dst] = std::sqrt(r[in.a]); break;
+         case CURVE_EXP:   r[in.dst] = std::exp(r[in.a]); break;
+         case CURVE_ABS:   r[in.dst] = std::fabs(r[in.a]); break;
+      }
+   }
+   return r[curve.result];
+}
+
+// Speed in pixels/sec after a direction has been held for t seconds
+static float sampleCurve(const SpeedCurve &curve, float t) {
+   float pos = t * (CURVE_LUT_SIZE / CURVE_LUT_SPAN_S);
+   if (pos >= (float)CURVE_LUT_SIZE) return std::fmin(std::fmax(evalCurve(curve, t), 0.0f), CURVE_MAX_SPEED); // NaN -> 0
+   int i = (int)pos;
+   float frac = pos - (float)i;
+   return curve.lut[i] + (curve.lut[i + 1] - curve.lut[i]) * frac;
+}
+
+// Recursive-descent compiler. Registers are allocated like a stack: every
+// sub-expression leaves its value in the next free register.
+struct CurveCompiler {
+   const char *src;
+   const char *error = nullptr;
+   SpeedCurve &out;
+   int nextReg = 0;
+   int constCount = 0;
+   
+   CurveCompiler(const char *text, SpeedCurve &curve) : src(text), out(curve) {}
+   
+   void skipSpace() {
+      while (*src == ' ' || *src == '\t') ++src;
+   }
+   
+   bool accept(char c) {
+      skipSpace();
+      if (*src != c) return false;
+      ++src;
+      return true;
+   }
+   
+   int fail(const char *message) {
+      if (!error) error = message;
+      return 0;
+   }
+   
+   int emit(uint8_t op, int a, int b) {
+      if (out.codeLen == CURVE_MAX_CODE) return fail("curve is too long");
+      if (nextReg == CURVE_MAX_REGS) return fail("curve is nested too deeply");
+      int dst = nextReg++;
+      out.code[out.codeLen++] = { op, (uint8_t)dst, (uint8_t)a, (uint8_t)b };
+      return dst;
+   }
+   
+   // Binary op on the two registers on top of the stack; the result replaces them
+   int emitBinary(uint8_t op, int lhs, int rhs) {
+      if (out.codeLen == CURVE_MAX_CODE) return fail("curve is too long");
+      out.code[out.codeLen++] = { op, (uint8_t)lhs, (uint8_t)lhs, (uint8_t)rhs };
+      nextReg = lhs + 1;
+      return lhs;
+   }
+   
+   int emitUnary(uint8_t op, int arg) {
+      if (out.codeLen == CURVE_MAX_CODE) return fail("curve is too long");
+      out.code[out.codeLen++] = { op, (uint8_t)arg, (uint8_t)arg, 0 };
+      return arg;
+   }
+   
+   // Plain decimal only (no hex, inf or nan), independent of the C locale
+   int number() {
+      float value = 0.0f;
+      std::from_chars_result parsed = std::from_chars(src, src + std::strlen(src), value, std::chars_format::general);
+      if (parsed.ec == std::errc::result_out_of_range) return fail("number out of range in curve");
+      if (parsed.ec != std::errc() || parsed.ptr == src || !std::isfinite(value)) return fail("expected a number");
+      src = parsed.ptr;
+      
+      int k = 0;
+      while (k < constCount && out.consts[k] != value) ++k;
+      if (k == CURVE_MAX_CONSTS) return fail("too many constants in curve");
+      if (k == constCount) out.consts[constCount++] = value;
+      return emit(CURVE_CONST, k, 0);
+   }
+   
+   int primary() {
+      skipSpace();
+      if ((*src >= '0' && *src <= '9') || *src == '.') return number();
+      if (accept('(')) {
+         int r = expr();
+         if (!accept(')')) return fail("expected ')'");
+         return r;
+      }
+      
+      const char *start = src;
+      while ((*src >= 'a' && *src <= 'z') || (*src >= 'A' && *src <= 'Z')) ++src;
+      size_t len = (size_t)(src - start);
+      if (len == 1 && *start == 't') return emit(CURVE_T, 0, 0);
+      if (len == 0) return fail(*src ? "unexpected character in curve" : "unexpected end of curve");
+      
+      struct Function { const char *name; int args; uint8_t op; };
+      static constexpr Function FUNCTIONS[] = {
+         { "min", 2, CURVE_MIN }, { "max", 2, CURVE_MAX }, { "clamp", 3, CURVE_MIN },
+         { "sqrt", 1, CURVE_SQRT }, { "exp", 1, CURVE_EXP }, { "abs", 1, CURVE_ABS },
+      };
+      for (const Function &f : FUNCTIONS) {
+         if (std::strlen(f.name) != len || std::strncmp(f.name, start, len) != 0) continue;
+         if (!accept('(')) return fail("expected '(' after function name");
+         int first = expr();
+         if (f.args == 1) {
+            if (!accept(')')) return fail("expected ')'");
+            return emitUnary(f.op, first);
+         }
+         if (!accept(',')) return fail("expected ','");
+         int second = expr();
+         if (f.args == 3) {
+            // clamp(x, lo, hi) = min(max(x, lo), hi)
+            int lo = emitBinary(CURVE_MAX, first, second);
+            if (!accept(',')) return fail("expected ','");
+            int hi = expr();
+            if (!accept(')')) return fail("expected ')'");
+            return emitBinary(CURVE_MIN, lo, hi);
+         }
+         if (!accept(')')) return fail("expected ')'");
+         return emitBinary(f.op, first, second);
+      }
+      return fail("unknown name in curve");
+   }
+   
+   int power() {
+      int base = primary();
+      if (accept('^')) return emitBinary(CURVE_POW, base, unary());
+      return base;
+   }
+   
+   int unary() {
+      if (accept('-')) return emitUnary(CURVE_NEG, unary());
+      return power();
+   }
+   
+   int term() {
+      int lhs = unary();
+      for (;;) {
+         if (accept('*')) lhs = emitBinary(CURVE_MUL, lhs, unary());
+         else if (accept('/')) lhs = emitBinary(CURVE_DIV, lhs, unary());
+         else return lhs;
+      }
+   }
+   
+   int expr() {
+      int lhs = term();
+      for (;;) {
+         if (accept('+')) lhs = emitBinary(CURVE_ADD, lhs, term());
+         else if (accept('-')) lhs = emitBinary(CURVE_SUB, lhs, term());
+         else return lhs;
+      }
+   }
+};
+
+// Compiles a curve expression and samples its lookup table. Returns nullptr on
+// success, otherwise a description of the first error.
+const char *compileCurve(const char *text, SpeedCurve &curve) {
+   curve = SpeedCurve();
+   CurveCompiler compiler(text, curve);
+   curve.result = compiler.expr();
+   compiler.skipSpace();
+   if (!compiler.error && *compiler.src != '\0') compiler.fail("unexpected text after curve");
+   if (compiler.error) {
+      curve.valid = false;
+      return compiler.error;
+   }
+   
+   for (int i = 0; i <= CURVE_LUT_SIZE; ++i) {
+      float speed = evalCurve(curve, CURVE_LUT_SPAN_S * (float)i / CURVE_LUT_SIZE);
+      if (!std::isfinite(speed)) return "curve is not finite during ramp-up (e.g. 1/t at t = 0)";
+      if (speed < 0.0f) return "curve goes negative during ramp-up";
+      curve.lut[i] = std::fmin(speed, CURVE_MAX_SPEED);
+   }
+   curve.valid = true;
+   return nullptr;
+}
+
+// Compiles every profile's curve at startup; a bad curve falls back to maxSpeed
+void compileProfileCurves() {
+   for (int i = 0; i < PROFILE_COUNT; ++i) {
+      const Profile &profile = i == 0 ? DEFAULT_PROFILE : PROFILES[i - 1];
+      if (!profile.speedCurve) continue;
+      
+      const char *error = compileCurve(profile.speedCurve, g_curves[i]);
+      if (error) {
+         wchar_t message[256];
+         swprintf(message, 256, L"Invalid speed curve for %ls: %hs. Using the constant top speed.",
+            i == 0 ? L"the default profile" : profile.exeName, error);
+         MessageBoxW(NULL, message, L"mousekeys", MB_ICONWARNING);
+      }
+   }
+}
+
+// --- Plugins ---
+// DLLs in the "plugins" folder next to the executable (see mousekeys_plugin.h)
+static constexpr int MAX_PLUGINS = 8;
+
+struct LoadedPlugin {
+   HMODULE module;
+   mk_plugin desc;
+};
+
+LoadedPlugin g_plugins[MAX_PLUGINS];
+int g_pluginCount = 0;
+const mk_plugin *g_filters[MAX_PLUGINS];
+int g_filterCount = 0;
+const mk_plugin *g_motionPlugin = nullptr;
+
+// Directory containing the executable, with a trailing backslash
+std::wstring exeDirectory() {
+   wchar_t path[MAX_PATH];
+   DWORD len = GetModuleFileNameW(NULL, path, MAX_PATH);
+   std::wstring dir(path, len);
+   size_t slash = dir.find_last_of(L"\\/");
+   return slash == std::wstring::npos ? std::wstring() : dir.substr(0, slash + 1);
+}
+
+// Loads every plugin once at startup, before the physics thread starts
+void loadPlugins() {
+   std::wstring dir = exeDirectory() + L"plugins\\";
+   WIN32_FIND_DATAW found;
+   HANDLE find = FindFirstFileW((dir + L"*.dll").c_str(), &found);
+   if (find == INVALID_HANDLE_VALUE) return;
+   
+   do {
+      if (g_pluginCount == MAX_PLUGINS) break;
+      HMODULE module = LoadLibraryW((dir + found.cFileName).c_str());
+      if (!module) continue;
+      
+      auto init = reinterpret_cast<mk_plugin_init_fn>(
+         reinterpret_cast<void *>(GetProcAddress(module, MK_PLUGIN_INIT_SYMBOL)));
+      mk_plugin desc = {};
+      bool ok = init && init(MK_PLUGIN_ABI_VERSION, &desc) == 0
+         && desc.abi_version >= 1 && desc.abi_version <= MK_PLUGIN_ABI_VERSION
+         && (!(desc.kind & MK_PLUGIN_FILTER) || desc.filter)
+         && (!(desc.kind & MK_PLUGIN_MOTION) || desc.motion);
+      if (!ok) {
+         FreeLibrary(module);
+         continue;
+      }
+      
+      LoadedPlugin &plugin = g_plugins[g_pluginCount++];
+      plugin.module = module;
+      plugin.desc = desc;
+      if (desc.kind & MK_PLUGIN_FILTER) g_filters[g_filterCount++] = &plugin.desc;
+      if ((desc.kind & MK_PLUGIN_MOTION) && !g_motionPlugin) g_motionPlugin = &plugin.desc;
+   } while (FindNextFileW(find, &found));
+   
+   FindClose(find);
+}
+
+// Lets every plugin drop per-enable state (physics thread, once per disable)
+static void resetPlugins() {
+   for (int i = 0; i < g_pluginCount; ++i) {
+      if (g_plugins[i].desc.reset) g_plugins[i].desc.reset(g_plugins[i].desc.user);
+   }
+}
+
+// Unloads plugins after the physics thread has stopped
+void unloadPlugins() {
+   for (int i = g_pluginCount - 1; i >= 0; --i) {
+      if (g_plugins[i].desc.shutdown) g_plugins[i].desc.shutdown(g_plugins[i].desc.user);
+      FreeLibrary(g_plugins[i].module);
+   }
+   g_pluginCount = 0;
+   g_filterCount = 0;
+   g_motionPlugin = nullptr;
+}
+
+// Low-level keyboard hook procedure. Every keystroke on the system waits on
+// this, so the time spent in it is recorded for the metrics exporter.
+LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
+   LONGLONG start = qpcNow();
+   LRESULT result = handleKeyboardHook(nCode, wParam, lParam);
+   LONGLONG elapsed = qpcNow() - start;
+   g_stats.hookLatency.record((uint64_t)(elapsed * 1000000000LL / g_qpcFrequency));
+   return result;
+}
+
+// Low-level mouse hook, installed only while control is enabled. Physical
+// motion (anything not injected) either hands the new position to physics or
+// suspends control, so keyboard movement never fights the real mouse.
+LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
+   if (nCode == HC_ACTION && wParam == WM_MOUSEMOVE) {
+      const MSLLHOOKSTRUCT *ms = reinterpret_cast<const MSLLHOOKSTRUCT *>(lParam);
+      if (!(ms->flags & LLMHF_INJECTED)) {
+         if (MOUSE_SUSPENDS_CONTROL) {
+            setEnabled(false);
+         } else {
+            g_cursorRequests.physicalPos.store(((uint64_t)(uint32_t)ms->pt.x << 32) | (uint32_t)ms->pt.y);
+            g_cursorRequests.physicalMoved.store(true);
+            wakePhysics();
+         }
+      }
+   }
+   return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
+}
+
+// --- Hook lifetime ---
+// While control is off, the only key that matters is the toggle, so the
+// low-level hook is removed and Caps Lock is registered as a hotkey instead.
+// If the hotkey is taken by another program the hook simply stays installed.
+// Everything here runs on the main thread.
+static constexpr int TOGGLE_HOTKEY_ID = 1;
+bool g_hotkeyRegistered = false;
+bool g_capsBeforeHotkey = false; // Caps Lock toggle state when the hotkey was armed
+
+// Makes the hooks and hotkey match `enabled`
+static void syncHook() {
+   if (g_control.enabled.load() && !g_mouseHook) {
+      g_mouseHook = SetWindowsHookEx(WH_MOUSE_LL, LowLevelMouseProc, NULL, 0);
+   } else if (!g_control.enabled.load() && g_mouseHook) {
+      UnhookWindowsHookEx(g_mouseHook);
+      g_mouseHook = nullptr;
+   }
+   
+   if (g_control.enabled.load() || !HOOK_FREE_WHEN_DISABLED) {
+      if (!g_hHook) g_hHook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, NULL, 0);
+      if (!g_hHook) setEnabled(false); // no hook, no control; re-arm the hotkey
+      if (g_hHook && g_hotkeyRegistered) {
+         UnregisterHotKey(NULL, TOGGLE_HOTKEY_ID);
+         g_hotkeyRegistered = false;
+      }
+   } else {
+      if (!g_hotkeyRegistered) {
+         g_hotkeyRegistered = RegisterHotKey(NULL, TOGGLE_HOTKEY_ID, MOD_NOREPEAT, VK_CAPITAL) != FALSE;
+         g_capsBeforeHotkey = (GetKeyState(VK_CAPITAL) & 1) != 0;
+      }
+      if (g_hotkeyRegistered && g_hHook) {
+         UnhookWindowsHookEx(g_hHook);
+         g_hHook = nullptr;
+         // Releases are not seen without the hook, so start clean on the next enable
+         clearHeldKeys();
+      }
+   }
+   
+   LONGLONG toggled = g_control.toggleTime.exchange(0, std::memory_order_relaxed);
+   if (toggled) {
+      g_stats.hookTransition.record((uint64_t)((qpcNow() - toggled) * 1000000000LL / g_qpcFrequency));
+   }
+}
+
+// The hotkey does not stop Caps Lock from toggling the way the hook does; tap
+// it once more (past the hook, via the tag) if the state changed
+static void restoreCapsLock() {
+   if (((GetKeyState(VK_CAPITAL) & 1) != 0) == g_capsBeforeHotkey) return;
+   INPUT inputs[2] = {};
+   inputs[0].type = inputs[1].type = INPUT_KEYBOARD;
+   inputs[0].ki.wVk = inputs[1].ki.wVk = VK_CAPITAL;
+   inputs[0].ki.dwExtraInfo = inputs[1].ki.dwExtraInfo = INJECTED_KEY_TAG;
+   inputs[1].ki.dwFlags = KEYEVENTF_KEYUP;
+   SendInput(2, inputs, sizeof(INPUT));
+}
+
+// --- Fixed-point integration ---
+// With FIXED_POINT_POSITION, movement at the tick's speed (the built-in linear
+// integrator and MOMENTUM while keys drive it) keeps the position in 32.32
+// fixed point. Every step is an integer add plus a portable 64x64->128
+// multiply, so replaying the same inputs and tick lengths lands on the same
+// sub-pixel on every compiler and FP mode (no FMA contraction or x87 excess
+// precision). Conversions to and from double are exact for screen-sized values.
+// Not covered: glide coasting and magnetism go through exp(), and motion
+// plugins bring their own arithmetic, so replays that use them are only as
+// repeatable as the platform's libm or the plugin.
+typedef int64_t fixed32; // Q32.32
+static constexpr double FIXED_ONE = 4294967296.0;
+
+static fixed32 toFixed(double v) {
+   return (fixed32)std::llround(v * FIXED_ONE);
+}
+
+static double fromFixed(fixed32 v) {
+   return (double)v / FIXED_ONE;
+}
+
+// mulFixed without a 128-bit type: unsigned 32-bit partial products, then the
+// two's complement correction. Always compiled so it can be checked against
+// the __int128 path.
+static fixed32 mulFixedPortable(fixed32 a, fixed32 b) {
+   uint64_t ua = (uint64_t)a, ub = (uint64_t)b;
+   uint64_t ll = (ua & 0xFFFFFFFFu) * (ub & 0xFFFFFFFFu);
+   uint64_t lh = (ua & 0xFFFFFFFFu) * (ub >> 32);
+   uint64_t hl = (ua >> 32) * (ub & 0xFFFFFFFFu);
+   uint64_t hh = (ua >> 32) * (ub >> 32);
+   uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+   uint64_t lo = (mid << 32) | (ll & 0xFFFFFFFFu);
+   uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+   if (a < 0) hi -= ub;
+   if (b < 0) hi -= ua;
+   return (fixed32)((hi << 32) | (lo >> 32));
+}
+
+// (a * b) >> 32 over the full 128-bit product (rounds toward -inf)
+static fixed32 mulFixed(fixed32 a, fixed32 b) {
+#if defined(__SIZEOF_INT128__)
+   return (fixed32)(((__int128)a * b) >> 32);
+#else
+   return mulFixedPortable(a, b);
+#endif
+}
+
+// Engine state carried from one physics tick to the next
+struct PhysicsState {
+   double px = 0.0, py = 0.0;
+   double vx = 0.0, vy = 0.0; // MOMENTUM velocity (pixels/sec)
+   float dx = 0.0f;
+   float dy = 0.0f;
+   float heldTime = 0.0f; // seconds a direction has been held, for speed curves
+   double trailX = 0.0, trailY = 0.0; // last position pushed to the overlay trail
+   bool trailFed = false;
+   double lensX = 0.0, lensY = 0.0; // position the lens was last woken for
+   fixed32 fixedX = 0, fixedY = 0; // FIXED_POINT_POSITION integrator state
+   uint8_t dirDown = 0; // direction slots held as of the last tick, for SOCD
+   uint32_t dirSeq = 0; // press counter; dirStamp[s] is the value at slot s's latest press
+   uint32_t dirStamp[DIRECTION_SLOT_COUNT] = {};
+   uint8_t flickDown = 0, flickArmed = 0; // direction slots down / tapped once, for flicks
+   uint32_t flickTapMs[DIRECTION_SLOT_COUNT] = {}; // time of each slot's last first tap
+   int lockAxis = 0; // AxisLock: 0 = not chosen yet, 1 = horizontal, 2 = vertical
+   bool wasActive = false; // control was on last tick, so plugins are reset once per disable
+   mk_key_event events[KEY_EVENT_RING_SIZE]; // this tick's key events
+};
+
+// Apply an SOCD policy (SOCD_POLICY in the tick) to the held-direction mask. Presses are ordered by the
+// tick's key events (auto-repeat does not re-stamp), so a reversal wins on the
+// tick it arrives. The hook's mask stays the authority on what is held: a slot
+// that is held without a press in the ring (e.g. the ring overflowed) counts
+// as the newest press.
+static uint8_t resolveSocd(PhysicsState &st, Socd policy, uint8_t held, const mk_key_event *events, uint32_t count) {
+   uint8_t down = st.dirDown, stamped = 0;
+   for (uint32_t i = 0; i < count; ++i) {
+      int slot = directionSlotOf(events[i].action);
+      if (slot < 0) continue;
+      uint8_t bit = (uint8_t)(1u << slot);
+      if (!events[i].down) {
+         down &= (uint8_t)~bit;
+      } else if (!(down & bit)) {
+         down |= bit;
+         stamped |= bit;
+         st.dirStamp[slot] = ++st.dirSeq;
+      }
+   }
+   uint8_t unstamped = held & (uint8_t)~(st.dirDown | stamped);
+   for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+      if (unstamped & (1u << s)) st.dirStamp[s] = ++st.dirSeq;
+   }
+   st.dirDown = held;
+   
+   uint8_t out = held;
+   for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+      int o = g_oppositeSlot[s];
+      if (o < s || !(held & (1u << s)) || !(held & (1u << o))) continue; // each held pair once
+      bool sNewer = (int32_t)(st.dirStamp[s] - st.dirStamp[o]) > 0;
+      int loser;
+      if (policy == Socd::LastWins) loser = sNewer ? o : s;
+      else if (policy == Socd::FirstWins) loser = sNewer ? s : o;
+      else if (policy == Socd::Priority && DIRECTION_SLOTS[s].priority != DIRECTION_SLOTS[o].priority) loser = DIRECTION_SLOTS[s].priority ? o : s;
+      else continue; // neutral: the direction table cancels the pair
+      out &= (uint8_t)~(1u << loser);
+   }
+   return out;
+}
+
+// The OS side of a physics tick. The real desktop moves the cursor and
+// injects buttons; the soak simulator swaps in a virtual one.
+struct Desktop {
+   bool (*getCursor)(POINT *p);
+   void (*setCursor)(int x, int y);
+   void (*buttonDown)(bool left);
+   void (*buttonUp)(bool left);
+   void (*click)(bool left);
+   int (*metric)(int index); // GetSystemMetrics
+};
+
+static const Desktop OS_DESKTOP = {
+   [](POINT *p) { return GetCursorPos(p) != FALSE; },
+   [](int x, int y) { SetCursorPos(x, y); },
+   sendMouseDown,
+   sendMouseUp,
+   sendMouseClick,
+   [](int index) { return GetSystemMetrics(index); },
+};
+
+// Launch a flick when a direction is tapped twice within FLICK_WINDOW_MS
+static void detectFlicks(PhysicsState &st, const mk_key_event *events, uint32_t count) {
+   for (uint32_t i = 0; i < count; ++i) {
+      int slot = directionSlotOf(events[i].action);
+      if (slot < 0) continue;
+      uint8_t bit = (uint8_t)(1u << slot);
+      if (!events[i].down) {
+         st.flickDown &= (uint8_t)~bit;
+         continue;
+      }
+      if (st.flickDown & bit) continue; // auto-repeat
+      st.flickDown |= bit;
+      if ((st.flickArmed & bit) && events[i].time_ms - st.flickTapMs[slot] <= FLICK_WINDOW_MS) {
+         const DirectionVector &dir = g_directionTable[bit];
+         st.vx = dir.x * FLICK_SPEED_PIX_PER_S;
+         st.vy = dir.y * FLICK_SPEED_PIX_PER_S;
+         st.flickArmed &= (uint8_t)~bit; // a third tap starts a new pair
+      } else {
+         st.flickArmed |= bit;
+         st.flickTapMs[slot] = events[i].time_ms;
+      }
+   }
+}
+
+// Linear step at the tick's speed in fixed point (FIXED_POINT_POSITION)
+static void stepFixed(PhysicsState &st, const mk_tick &tick, double dt) {
+   // Re-seed whenever something else moved the cursor (warp, mouse, magnetism, clamp, glide)
+   if (fromFixed(st.fixedX) != st.px || fromFixed(st.fixedY) != st.py) {
+      st.fixedX = toFixed(st.px);
+      st.fixedY = toFixed(st.py);
+   }
+   fixed32 move = mulFixed(toFixed(tick.speed), toFixed(dt));
+   st.fixedX += mulFixed(move, toFixed(tick.dir_x));
+   st.fixedY += mulFixed(move, toFixed(tick.dir_y));
+   st.px = fromFixed(st.fixedX);
+   st.py = fromFixed(st.fixedY);
+}
+
+// Linear step at the tick's speed in floating point
+static void stepFloat(PhysicsState &st, const mk_tick &tick, double dt) {
+   // Vanilla speed calcs w/ speed modifier
+   float move = tick.speed * (float)dt;
+   st.px += tick.dir_x * move;
+   st.py += tick.dir_y * move;
+}
+
+// MOMENTUM integrator. Held keys drive the cursor at the tick's speed unless
+// it is already going faster their way (a flick); otherwise it coasts, moving
+// by the exact integral of the decaying velocity, v * (1 - exp(-k dt)) / k.
+static void glide(PhysicsState &st, const mk_tick &tick, double dt) {
+   double hx = tick.dir_x * (double)tick.speed, hy = tick.dir_y * (double)tick.speed;
+   double v2 = st.vx * st.vx + st.vy * st.vy, h2 = hx * hx + hy * hy;
+   bool coast = (h2 == 0.0) ? v2 > 0.0 : (v2 > h2 && st.vx * hx + st.vy * hy > 0.0);
+   if (!coast) {
+      st.vx = hx;
+      st.vy = hy;
+      if (FIXED_POINT_POSITION) {
+         stepFixed(st, tick, dt);
+      } else {
+         st.px += hx * dt;
+         st.py += hy * dt;
+      }
+      return;
+   }
+   double decay = std::exp(-GLIDE_FRICTION_PER_S * dt);
+   double reach = (1.0 - decay) / GLIDE_FRICTION_PER_S;
+   st.px += st.vx * reach;
+   st.py += st.vy * reach;
+   st.vx *= decay;
+   st.vy *= decay;
+   if (st.vx * st.vx + st.vy * st.vy < GLIDE_STOP_PIX_PER_S * GLIDE_STOP_PIX_PER_S) {
+      st.vx = 0.0;
+      st.vy = 0.0;
+   }
+}
+
+// Axis lock: keep to whichever axis dominated when motion began. The other
+// component (and any glide along it) is exactly zero, so the sub-pixel
+// position on that axis never changes during a long drag.
+static void axisLock(PhysicsState &st, bool held) {
+   if (!held) {
+      st.lockAxis = 0;
+      return;
+   }
+   if (!st.lockAxis && (st.dx != 0.0f || st.dy != 0.0f)) st.lockAxis = (std::fabs(st.dx) >= std::fabs(st.dy)) ? 1 : 2;
+   if (st.lockAxis == 1) {
+      st.dx = (st.dx > 0.0f) ? 1.0f : (st.dx < 0.0f) ? -1.0f : 0.0f;
+      st.dy = 0.0f;
+      st.vy = 0.0;
+   } else if (st.lockAxis == 2) {
+      st.dx = 0.0f;
+      st.dy = (st.dy > 0.0f) ? 1.0f : (st.dy < 0.0f) ? -1.0f : 0.0f;
+      st.vx = 0.0;
+   }
+}
+
+// Adopts the OS cursor position unless it is still on the pixel physics last
+// put it on (see the lround in physicsTick), so a park or a disabled tick keeps
+// the sub-pixel remainder and the fixed-point state instead of re-seeding them
+static void resyncFromCursor(PhysicsState &st, POINT p) {
+   if (p.x == std::lround(st.px) && p.y == std::lround(st.py)) return;
+   st.px = (double)p.x;
+   st.py = (double)p.y;
+}
+
+// One physics step of dt seconds. Returns true when the tick was idle (control
+// on, nothing held, moving or pending), so the loop can park until woken.
+static bool physicsTick(PhysicsState &st, double dt, const Desktop &desktop) {
+   double &px = st.px, &py = st.py;
+   double &vx = st.vx, &vy = st.vy;
+   float &dx = st.dx, &dy = st.dy;
+   float &heldTime = st.heldTime;
+   double &trailX = st.trailX, &trailY = st.trailY;
+   bool &trailFed = st.trailFed;
+   double &lensX = st.lensX, &lensY = st.lensY;
+   mk_key_event *events = st.events;
+   g_stats.ticks.fetch_add(1, std::memory_order_relaxed);
+   
+   // Pick up a warp request (control pipe, hint mode); the disabled branch resyncs from the OS cursor
+   if (g_cursorRequests.warpPending.load() && g_cursorRequests.warpPending.exchange(false)) {
+      uint64_t target = g_cursorRequests.warpTarget.load();
+      px = (double)(int32_t)(uint32_t)(target >> 32);
+      py = (double)(int32_t)(uint32_t)target;
+      desktop.setCursor((int)px, (int)py);
+      if (g_cursorRequests.warpClick.exchange(false)) desktop.click(true);
+   }
+   
+   // Adopt physical mouse motion so the next keyboard move starts from there
+   if (g_cursorRequests.physicalMoved.load() && g_cursorRequests.physicalMoved.exchange(false)) {
+      uint64_t pos = g_cursorRequests.physicalPos.load();
+      px = (double)(int32_t)(uint32_t)(pos >> 32);
+      py = (double)(int32_t)(uint32_t)pos;
+   }
+   
+   double startX = px, startY = py; // for the snapshot's velocity
+   const Profile *profile = g_profile.load(std::memory_order_acquire);
+   const TargetIndex *targets = g_targetOwned.index.load(std::memory_order_acquire);
+   if (g_physicsOwned.targetSeen.load(std::memory_order_relaxed) != targets) {
+      g_physicsOwned.targetSeen.store(targets, std::memory_order_release);
+   }
+   
+   // If control enabled
+   bool active = g_control.enabled.load();
+   uint8_t modifiers = g_hookOwned.modifierMask.load(std::memory_order_relaxed); // HELD_* bits
+   bool idle = false;
+   if (active) {
+      st.wasActive = true;
+      
+      // This tick's key events, in arrival order
+      uint32_t eventCount = g_keyEvents.drain(events, KEY_EVENT_RING_SIZE);
+      
+      // Resolve held directions: one mask load and one table lookup, however
+      // many direction keys are bound. Opposite pairs go through SOCD_POLICY
+      // first; whatever still cancels (or nothing held) resolves to zero.
+      uint8_t held = g_hookOwned.directionMask.load(std::memory_order_relaxed);
+      if (SOCD_POLICY != Socd::Neutral) held = resolveSocd(st, SOCD_POLICY, held, events, eventCount);
+      if (MOMENTUM) detectFlicks(st, events, eventCount);
+      const DirectionVector &dir = ((modifiers & HELD_ANGLE_SNAP) ? g_snappedTable : g_directionTable)[held];
+      dx = dir.x;
+      dy = dir.y;
+      
+      axisLock(st, (modifiers & HELD_AXIS_LOCK) != 0);
+      float speed = (dx != 0.0f || dy != 0.0f) ? 1.0f : 0.0f;
+      
+      // // Apply acceleration
+      // vx += dx * ACCEL_PIX_PER_S2 * dt;
+      // vy += dy * ACCEL_PIX_PER_S2 * dt;
+      
+      // // Apply exponential friction
+      // float decay = std::expf(-FRICTION_PER_S * (float)dt);
+      // vx *= decay;
+      // vy *= decay;
+      
+      // // Clamp speed
+      // double speed = std::hypot(vx, vy);
+      // if (speed > MAX_SPEED_PIX_PER_S) {
+      //   double s = MAX_SPEED_PIX_PER_S / speed;
+      //   vx *= s;
+      //   vy *= s;
+      // }
+      
+      // // Integrate
+      // px += vx * dt;
+      // py += vy * dt;
+      
+      // Top speed for this tick, from the profile's curve if it has one
+      heldTime = (speed > 0.0f) ? heldTime + (float)dt : 0.0f;
+      const SpeedCurve &curve = g_curves[profileIndex(profile)];
+      float topSpeed = curve.valid ? sampleCurve(curve, heldTime) : profile->maxSpeed;
+      
+      // Bullet time: ease off on the final approach to a target (but not when leaving it)
+      float focusMult = 1.0f;
+      if (BULLET_TIME && speed > 0.0f) {
+         int hit = nearestTarget(*targets, px, py, BULLET_TIME_RADIUS_PX);
+         if (hit >= 0) {
+            const RECT &r = targets->rects[hit];
+            double tx = (r.left + r.right) * 0.5 - px, ty = (r.top + r.bottom) * 0.5 - py;
+            if (tx * dx + ty * dy > 0.0) {
+               float closeness = (float)(std::hypot(tx, ty) / BULLET_TIME_RADIUS_PX);
+               focusMult = BULLET_TIME_MIN_MULT + (1.0f - BULLET_TIME_MIN_MULT) * closeness;
+            }
+         }
+      }
+      
+      // Everything plugins get to see and change for this tick
+      float speedMult = (modifiers & HELD_SLOW) ? profile->slowMult : 1.0f;
+      mk_tick tick = {};
+      tick.dt = dt;
+      tick.x = px;
+      tick.y = py;
+      tick.dir_x = dx;
+      tick.dir_y = dy;
+      tick.speed = topSpeed * speedMult * focusMult;
+      tick.buttons = ((modifiers & HELD_LEFT_CLICK) ? MK_BUTTON_LEFT : 0u)
+         | ((modifiers & HELD_RIGHT_CLICK) ? MK_BUTTON_RIGHT : 0u);
+      tick.event_count = eventCount;
+      tick.events = events;
+      for (int i = 0; i < g_filterCount; ++i) {
+         g_filters[i]->filter(g_filters[i]->user, &tick);
+      }
+      
+      double fromX = px, fromY = py;
+      if (g_motionPlugin) {
+         g_motionPlugin->motion(g_motionPlugin->user, &tick);
+         px = tick.x;
+         py = tick.y;
+      } else if (MOMENTUM) {
+         glide(st, tick, dt);
+      } else if (FIXED_POINT_POSITION) {
+         stepFixed(st, tick, dt);
+      } else {
+         stepFloat(st, tick, dt);
+      }
+      
+      // AngleSnap: straighten whatever moved the cursor this tick (keys, a
+      // glide, a plugin), and the glide velocity with it so a flick coasts
+      // along the snapped line
+      if (modifiers & HELD_ANGLE_SNAP) {
+         double mx = px - fromX, my = py - fromY;
+         snapVector(mx, my);
+         px = fromX + mx;
+         py = fromY + my;
+         snapVector(vx, vy);
+      }
+      
+      // Magnetism: once the keys are released (and any glide has run out), settle onto the nearest target
+      if (speed == 0.0f && vx == 0.0 && vy == 0.0 && g_control.magnetOn.load(std::memory_order_relaxed)) {
+         int hit = nearestTarget(*targets, px, py, SNAP_RADIUS_PX);
+         if (hit >= 0) {
+            const RECT &r = targets->rects[hit];
+            double k = 1.0 - std::exp(-SNAP_RATE_PER_S * dt);
+            px += ((r.left + r.right) * 0.5 - px) * k;
+            py += ((r.top + r.bottom) * 0.5 - py) * k;
+         }
+      }
+      
+      // Plugins and curves (e.g. sqrt of a negative) can produce NaN or inf;
+      // stay where the cursor is rather than pass that to the OS
+      if (!std::isfinite(px) || !std::isfinite(py)) {
+         POINT curp = { 0, 0 };
+         desktop.getCursor(&curp);
+         px = (double)curp.x;
+         py = (double)curp.y;
+      }
+      
+      // Clamp to screen bounds
+      int screenW = desktop.metric(SM_CXSCREEN);
+      int screenH = desktop.metric(SM_CYSCREEN);
+      if (px < 0.0) {
+         px = 0.0;
+         vx = 0.0;
+      }
+      if (py < 0.0) {
+         py = 0.0;
+         vy = 0.0;
+      }
+      if (px > screenW - 1) {
+         px = screenW - 1;
+         vx = 0.0;
+      }
+      if (py > screenH - 1) {
+         py = screenH - 1;
+         vy = 0.0;
+      }
+      
+      // Move cursor
+      desktop.setCursor((int)std::lround(px), (int)std::lround(py));
+      
+      // Feed the overlay trail, one point per tick while moving
+      bool overlayOn = g_control.overlayOn.load(std::memory_order_relaxed);
+      if (overlayOn && (!trailFed || px != trailX || py != trailY)) {
+         g_trailRing.push({ (float)px, (float)py, qpcNow() });
+         wakeUi();
+         trailX = px;
+         trailY = py;
+      }
+      trailFed = overlayOn;
+      
+      // The lens follows the cursor while Left Shift (precision mode) is held
+      if (g_control.lensOn.load(std::memory_order_relaxed) && speedMult < 1.0f && (px != lensX || py != lensY)) {
+         wakeUi();
+         lensX = px;
+         lensY = py;
+      }
+      
+      // Look for key clicks and enable dragging
+      bool prevLeft = g_physicsOwned.prevLeft.load();
+      bool prevRight = g_physicsOwned.prevRight.load();
+      bool curLeft = (tick.buttons & MK_BUTTON_LEFT) != 0;
+      bool curRight = (tick.buttons & MK_BUTTON_RIGHT) != 0;
+      if (curLeft && !prevLeft) {
+         desktop.buttonDown(true); // start a drag (mouse button down)
+      }
+      if (!curLeft && prevLeft) {
+         desktop.buttonUp(true); // end drag (mouse button up)
+      }
+      if (curRight && !prevRight) {
+         desktop.buttonDown(false);
+      }
+      if (!curRight && prevRight) {
+         desktop.buttonUp(false);
+      }
+      
+      g_physicsOwned.prevLeft.store(curLeft);
+      g_physicsOwned.prevRight.store(curRight);
+      
+      // Nothing held, gliding or settling: no point ticking until something happens
+      idle = held == 0 && eventCount == 0 && vx == 0.0 && vy == 0.0 && !curLeft && !curRight
+         && std::fabs(px - startX) + std::fabs(py - startY) < 1e-3;
+   } else {
+      // Nothing consumes key events while disabled
+      g_keyEvents.drain(nullptr, KEY_EVENT_RING_SIZE);
+      trailFed = false;
+      st.dirDown = 0; // held keys are forgotten too; presses after enabling stamp afresh
+      st.flickDown = 0;
+      st.flickArmed = 0;
+      vx = 0.0; // no glide carries over into the next enable
+      vy = 0.0;
+      if (st.wasActive) resetPlugins(); // nor plugin motion state
+      st.wasActive = false;
+      
+      // Disabled mid-drag: let go of the buttons so none stays stuck down
+      if (g_physicsOwned.prevLeft.exchange(false)) desktop.buttonUp(true);
+      if (g_physicsOwned.prevRight.exchange(false)) desktop.buttonUp(false);
+      
+      // // If disabled, slowly zero velocity (so it doesn't fling when re-enabled)
+      // vx *= 0.6;
+      // vy *= 0.6;
+      
+      // If disabled (vanilla), set velocity to zero << *for some reason this isn't necessary*
+      // dx *= 0.0;
+      // dy *= 0.0;
+      
+      // Keeps px/py synced with current cursor location (when user moves with
+      // mouse). Physics parks after this tick, so this is a one-off read.
+      POINT curp;
+      if (desktop.getCursor(&curp)) resyncFromCursor(st, curp);
+   }
+   
+   // Let the HUD know if anything it shows has changed
+   uint32_t hud = 0;
+   if (active) {
+      hud = HUD_ENABLED
+         | ((modifiers & HELD_SLOW) ? HUD_SLOW : 0u)
+         | (g_physicsOwned.prevLeft.load() ? HUD_LEFT_HELD : 0u)
+         | (g_physicsOwned.prevRight.load() ? HUD_RIGHT_HELD : 0u);
+   }
+   g_snapshot.publish({ g_stats.ticks.load(std::memory_order_relaxed), px, py,
+      (float)((px - startX) / dt), (float)((py - startY) / dt), hud });
+   publishHudState(hud);
+   return idle;
+}
+
+// Physics & cursor movement loop that runs in its own thread
+void physicsLoop() {
+   // Get initial cursor position
+   POINT p;
+   if (!GetCursorPos(&p)) {
+      p.x = GetSystemMetrics(SM_CXSCREEN) / 2;
+      p.y = GetSystemMetrics(SM_CYSCREEN) / 2;
+   }
+   
+   // Vars initialize/reinitialize
+   PhysicsState st;
+   st.px = (double)p.x;
+   st.py = (double)p.y;
+   
+   using clock = std::chrono::high_resolution_clock;
+   auto last = clock::now();
+   const double targetDt = 1.0 / UPDATES_PER_SEC;
+   
+   while (g_control.running.load()) {
+      auto now = clock::now();
+      std::chrono::duration<double> elapsed = now - last;
+      double dt = elapsed.count();
+
+      if (dt < 1e-9) dt = targetDt;
+      if (dt > 2.0 * targetDt) g_stats.tickOverruns.fetch_add(1, std::memory_order_relaxed);
+      
+      // Clamp dt to avoid huge jumps
+      if (dt > 0.05) dt = 0.05;
+      last = now;
+      
+      bool idle = physicsTick(st, dt, OS_DESKTOP);
+      
+      // Park while disabled or idle: nothing moves, so there is nothing to
+      // poll. The cursor is read once on waking, in case something else moved
+      // it meanwhile; if it has not, the sub-pixel position is kept.
+      bool enabled = g_control.enabled.load();
+      if ((!enabled || idle) && g_physicsWake) {
+         g_physicsOwned.parked.store(true);
+         std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with wakePhysics
+         bool pending = g_cursorRequests.warpPending.load() || g_cursorRequests.physicalMoved.load()
+            || g_keyEvents.head.load() != g_keyEvents.tail.load()
+            || g_targetOwned.index.load() != g_physicsOwned.targetSeen.load(); // publish that raced the park
+         if (g_control.enabled.load() == enabled && !pending && g_control.running.load()) {
+            WaitForSingleObject(g_physicsWake, INFINITE);
+         }
+         g_physicsOwned.parked.store(false);
+         POINT curp;
+         if (GetCursorPos(&curp)) resyncFromCursor(st, curp);
+         last = clock::now();
+         continue;
+      }
+      
+      // Sleep to approximate target update rate (use high-res sleep)
+      std::this_thread::sleep_for(std::chrono::duration<double>(targetDt));
+   }
+}
+
+// --- Per-application profiles ---
+// Looks up the profile for an executable name (no path)
+const Profile *findProfile(const wchar_t *exeName) {
+   for (const Profile &profile : PROFILES) {
+      if (lstrcmpiW(profile.exeName, exeName) == 0) return &profile;
+   }
+   return &DEFAULT_PROFILE;
+}
+
+// Resolves the profile for the process owning a window. Runs on the main thread
+// only when the foreground window changes, never per tick.
+const Profile *profileForWindow(HWND hwnd) {
+   DWORD pid = 0;
+   if (!hwnd || !GetWindowThreadProcessId(hwnd, &pid) || pid == 0) return &DEFAULT_PROFILE;
+   
+   HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+   if (!process) return &DEFAULT_PROFILE;
+   
+   wchar_t path[MAX_PATH];
+   DWORD len = MAX_PATH;
+   BOOL ok = QueryFullProcessImageNameW(process, 0, path, &len);
+   CloseHandle(process);
+   if (!ok) return &DEFAULT_PROFILE;
+   
+   const wchar_t *exeName = path;
+   for (const wchar_t *c = path; *c; ++c) {
+      if (*c == L'\\' || *c == L'/') exeName = c + 1;
+   }
+   return findProfile(exeName);
+}
+
+void refreshProfile() {
+   g_profile.store(profileForWindow(GetForegroundWindow()), std::memory_order_release);
+}
+
+// Foreground-change notification (delivered through the main thread's message loop)
+void CALLBACK onForegroundChanged(HWINEVENTHOOK, DWORD, HWND hwnd, LONG, LONG, DWORD, DWORD) {
+   g_profile.store(profileForWindow(hwnd), std::memory_order_release);
+   invalidateTargets();
+}
+
+// --- Target collection ---
+// Collects clickable element rectangles from the foreground window through UI
+// Automation on its own thread, since a FindAll on a large window can take a
+// noticeable fraction of a second.
+static void collectTargets(IUIAutomation *uia, HWND hwnd, std::vector<RECT> &out) {
+   out.clear();
+   IUIAutomationElement *root = nullptr;
+   if (!hwnd || FAILED(uia->ElementFromHandle(hwnd, &root)) || !root) return;
+   
+   // Any on-screen element of a clickable control type
+   static constexpr long CLICKABLE_TYPES[] = {
+      UIA_ButtonControlTypeId, UIA_HyperlinkControlTypeId, UIA_MenuItemControlTypeId,
+      UIA_CheckBoxControlTypeId, UIA_RadioButtonControlTypeId, UIA_TabItemControlTypeId,
+      UIA_ListItemControlTypeId, UIA_TreeItemControlTypeId, UIA_ComboBoxControlTypeId,
+      UIA_SplitButtonControlTypeId,
+   };
+   IUIAutomationCondition *typeConds[sizeof(CLICKABLE_TYPES) / sizeof(CLICKABLE_TYPES[0])] = {};
+   int typeCount = 0;
+   for (long type : CLICKABLE_TYPES) {
+      VARIANT v;
+      v.vt = VT_I4;
+      v.lVal = type;
+      if (SUCCEEDED(uia->CreatePropertyCondition(UIA_ControlTypePropertyId, v, &typeConds[typeCount]))) ++typeCount;
+   }
+   VARIANT onScreen;
+   onScreen.vt = VT_BOOL;
+   onScreen.boolVal = VARIANT_FALSE;
+   IUIAutomationCondition *anyType = nullptr, *visible = nullptr, *condition = nullptr;
+   uia->CreateOrConditionFromNativeArray(typeConds, typeCount, &anyType);
+   uia->CreatePropertyCondition(UIA_IsOffscreenPropertyId, onScreen, &visible);
+   if (anyType && visible) uia->CreateAndCondition(anyType, visible, &condition);
+   
+   // Fetch every bounding rectangle in one cross-process round trip
+   IUIAutomationCacheRequest *cache = nullptr;
+   IUIAutomationElementArray *found = nullptr;
+   if (condition && SUCCEEDED(uia->CreateCacheRequest(&cache)) && cache) {
+      cache->AddProperty(UIA_BoundingRectanglePropertyId);
+      root->FindAllBuildCache(TreeScope_Descendants, condition, cache, &found);
+   }
+   
+   int count = 0;
+   if (found) found->get_Length(&count);
+   for (int i = 0; i < count; ++i) {
+      IUIAutomationElement *element = nullptr;
+      if (FAILED(found->GetElement(i, &element)) || !element) continue;
+      RECT r;
+      if (SUCCEEDED(element->get_CachedBoundingRectangle(&r))) out.push_back(r);
+      element->Release();
+   }
+   
+   if (found) found->Release();
+   if (cache) cache->Release();
+   if (condition) condition->Release();
+   if (visible) visible->Release();
+   if (anyType) anyType->Release();
+   for (int i = 0; i < typeCount; ++i) typeConds[i]->Release();
+   root->Release();
+}
+
+// Top-down 32-bit DIB selected into its own memory DC
+static bool createDibDc(int width, int height, HDC &dc, HBITMAP &bitmap, uint32_t *&pixels) {
+   dc = CreateCompatibleDC(NULL);
+   if (!dc) return false;
+   BITMAPINFO bmi = {};
+   bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+   bmi.bmiHeader.biWidth = width;
+   bmi.bmiHeader.biHeight = -height;
+   bmi.bmiHeader.biPlanes = 1;
+   bmi.bmiHeader.biBitCount = 32;
+   bmi.bmiHeader.biCompression = BI_RGB;
+   void *bits = nullptr;
+   bitmap = CreateDIBSection(dc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+   if (!bitmap) return false;
+   pixels = static_cast<uint32_t *>(bits);
+   SelectObject(dc, bitmap);
+   return true;
+}
+
+// --- Vision target detection ---
+// Finds button-like boxes in a screenshot: luma conversion and a 3x3 Sobel
+// edge pass (SSE2, split into row bands across cores), then run-based
+// connected components whose bounding boxes are filtered by size.
+template <typename Fn>
+static void parallelRows(int rows, Fn fn) {
+   int workers = (int)std::thread::hardware_concurrency();
+   if (workers < 1) workers = 1;
+   if (workers > 16) workers = 16;
+   if (rows < 256) workers = 1;
+   
+   int band = (rows + workers - 1) / workers;
+   std::vector<std::thread> pool;
+   for (int begin = band; begin < rows; begin += band) {
+      pool.emplace_back(fn, begin, begin + band < rows ? begin + band : rows);
+   }
+   fn(0, band < rows ? band : rows);
+   for (std::thread &t : pool) t.join();
+}
+
+// BGRA -> 8-bit luma, (77 R + 150 G + 29 B) >> 8
+static void lumaRow(const uint32_t *in, uint8_t *out, int width) {
+   int x = 0;
+#ifdef MOUSEKEYS_SSE2
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i weights = _mm_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0);
+   for (; x + 4 <= width; x += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x));
+      // Per pixel: (29 B + 150 G) and (77 R + 0 A) in adjacent 32-bit lanes
+      __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights);
+      __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights);
+      __m128i even = _mm_unpacklo_epi64(_mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 0, 2, 0)),
+         _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 0, 2, 0)));
+      __m128i odd = _mm_unpacklo_epi64(_mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 3, 1)),
+         _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 3, 1)));
+      __m128i luma = _mm_srli_epi32(_mm_add_epi32(even, odd), 8);
+      luma = _mm_packs_epi32(luma, luma);
+      luma = _mm_packus_epi16(luma, luma);
+      int packed = _mm_cvtsi128_si32(luma);
+      std::memcpy(out + x, &packed, 4);
+   }
+#endif
+   for (; x < width; ++x) {
+      uint32_t p = in[x];
+      out[x] = (uint8_t)((((p >> 16) & 0xFF) * 77 + ((p >> 8) & 0xFF) * 150 + (p & 0xFF) * 29) >> 8);
+   }
+}
+
+// Edge mask (0/1) for row y of a luma image; border pixels are never edges
+static void sobelRow(const uint8_t *luma, int width, int height, int y, uint8_t *out) {
+   if (y == 0 || y == height - 1) {
+      std::memset(out, 0, width);
+      return;
+   }
+   const uint8_t *a = luma + (size_t)(y - 1) * width;
+   const uint8_t *b = luma + (size_t)y * width;
+   const uint8_t *c = luma + (size_t)(y + 1) * width;
+   out[0] = 0;
+   int x = 1;
+#ifdef MOUSEKEYS_SSE2
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i threshold = _mm_set1_epi16(VISION_EDGE_THRESHOLD);
+   const __m128i one = _mm_set1_epi8(1);
+   auto load8 = [&](const uint8_t *p) {
+      return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), zero);
+   };
+   for (; x + 8 < width; x += 8) {
+      __m128i a0 = load8(a + x - 1), a1 = load8(a + x), a2 = load8(a + x + 1);
+      __m128i b0 = load8(b + x - 1), b2 = load8(b + x + 1);
+      __m128i c0 = load8(c + x - 1), c1 = load8(c + x), c2 = load8(c + x + 1);
+      __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_sub_epi16(c2, c0)),
+         _mm_slli_epi16(_mm_sub_epi16(b2, b0), 1));
+      __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(c0, c2), _mm_slli_epi16(c1, 1)),
+         _mm_add_epi16(_mm_add_epi16(a0, a2), _mm_slli_epi16(a1, 1)));
+      __m128i mag = _mm_add_epi16(_mm_max_epi16(gx, _mm_sub_epi16(zero, gx)),
+         _mm_max_epi16(gy, _mm_sub_epi16(zero, gy)));
+      __m128i edge = _mm_cmpgt_epi16(mag, threshold);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm_and_si128(_mm_packs_epi16(edge, edge), one));
+   }
+#endif
+   for (; x < width - 1; ++x) {
+      int gx = (a[x + 1] - a[x - 1]) + 2 * (b[x + 1] - b[x - 1]) + (c[x + 1] - c[x - 1]);
+      int gy = (c[x - 1] + 2 * c[x] + c[x + 1]) - (a[x - 1] + 2 * a[x] + a[x + 1]);
+      out[x] = (std::abs(gx) + std::abs(gy)) > VISION_EDGE_THRESHOLD ? 1 : 0;
+   }
+   out[width - 1] = 0;
+}
+
+// A horizontal run of edge pixels (gaps up to VISION_GAP_PX bridged)
+struct EdgeRun {
+   int y, x0, x1; // inclusive
+};
+
+static int findRoot(std::vector<int> &parent, int i) {
+   while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+   }
+   return i;
+}
+
+// Detects button-like boxes in a BGRA image (top-down, width x height) and
+// appends them to out, offset by (originX, originY)
+void detectTargets(const uint32_t *pixels, int width, int height, int originX, int originY, std::vector<RECT> &out) {
+   std::vector<uint8_t> luma((size_t)width * height);
+   std::vector<uint8_t> edges((size_t)width * height);
+   parallelRows(height, [&](int begin, int end) {
+      for (int y = begin; y < end; ++y) lumaRow(pixels + (size_t)y * width, luma.data() + (size_t)y * width, width);
+   });
+   parallelRows(height, [&](int begin, int end) {
+      for (int y = begin; y < end; ++y) sobelRow(luma.data(), width, height, y, edges.data() + (size_t)y * width);
+   });
+   
+   // Runs per row, then union each run with the 8-connected runs of the row above
+   std::vector<EdgeRun> runs;
+   std::vector<int> rowStart(height + 1, 0);
+   for (int y = 0; y < height; ++y) {
+      rowStart[y] = (int)runs.size();
+      const uint8_t *row = edges.data() + (size_t)y * width;
+      int x = 0;
+      while (x < width) {
+         while (x < width && !row[x]) ++x;
+         if (x == width) break;
+         int x0 = x, last = x;
+         while (x < width && x - last <= VISION_GAP_PX + 1) {
+            if (row[x]) last = x;
+            ++x;
+         }
+         runs.push_back({ y, x0, last });
+         x = last + 1;
+      }
+   }
+   rowStart[height] = (int)runs.size();
+   
+   std::vector<int> parent(runs.size());
+   for (size_t i = 0; i < runs.size(); ++i) parent[i] = (int)i;
+   for (int y = 1; y < height; ++y) {
+      int above = rowStart[y - 1];
+      for (int i = rowStart[y]; i < rowStart[y + 1]; ++i) {
+         while (above < rowStart[y] && runs[above].x1 < runs[i].x0 - 1) ++above;
+         for (int j = above; j < rowStart[y] && runs[j].x0 <= runs[i].x1 + 1; ++j) {
+            int ra = findRoot(parent, i), rb = findRoot(parent, j);
+            if (ra != rb) parent[ra] = rb;
+         }
+      }
+   }
+   
+   // Bounding box per component, keeping those that look like a control
+   std::vector<RECT> boxes(runs.size(), RECT{ LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN });
+   for (size_t i = 0; i < runs.size(); ++i) {
+      RECT &box = boxes[findRoot(parent, (int)i)];
+      if (runs[i].x0 < box.left) box.left = runs[i].x0;
+      if (runs[i].x1 + 1 > box.right) box.right = runs[i].x1 + 1;
+      if (runs[i].y < box.top) box.top = runs[i].y;
+      if (runs[i].y + 1 > box.bottom) box.bottom = runs[i].y + 1;
+   }
+   for (size_t i = 0; i < runs.size(); ++i) {
+      if (parent[i] != (int)i) continue;
+      const RECT &box = boxes[i];
+      int w = box.right - box.left, h = box.bottom - box.top;
+      if (w < 12 || h < 8 || w > TARGET_MAX_W || h > TARGET_MAX_H) continue;
+      out.push_back({ box.left + originX, box.top + originY, box.right + originX, box.bottom + originY });
+   }
+}
+
+// Our own surfaces (HUD, overlay, lens, hints) that could not be excluded from
+// screen capture, which needs Windows 10 2004 (see createLayeredWindow). Only
+// the UI thread appends; vision drops whatever it detects on top of them.
+static constexpr int MAX_CAPTURED_SURFACES = 8;
+std::atomic<HWND> g_capturedSurfaces[MAX_CAPTURED_SURFACES];
+std::atomic<int> g_capturedSurfaceCount(0);
+
+// Drops rects from first on that overlap one of our visible captured surfaces
+static void dropSurfaceTargets(std::vector<RECT> &rects, size_t first) {
+   int count = g_capturedSurfaceCount.load();
+   for (int i = 0; i < count; ++i) {
+      HWND hwnd = g_capturedSurfaces[i].load();
+      RECT surface, overlap;
+      if (!IsWindowVisible(hwnd) || !GetWindowRect(hwnd, &surface)) continue;
+      size_t kept = first;
+      for (size_t j = first; j < rects.size(); ++j) {
+         if (!IntersectRect(&overlap, &rects[j], &surface)) rects[kept++] = rects[j];
+      }
+      rects.resize(kept);
+   }
+}
+
+// Captures a window's on-screen area and runs detectTargets on it
+static void detectWindowTargets(HWND hwnd, std::vector<RECT> &out) {
+   RECT r;
+   if (!hwnd || !GetWindowRect(hwnd, &r)) return;
+   int vx = GetSystemMetrics(SM_XVIRTUALSCREEN), vy = GetSystemMetrics(SM_YVIRTUALSCREEN);
+   int vw = GetSystemMetrics(SM_CXVIRTUALSCREEN), vh = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+   if (r.left < vx) r.left = vx;
+   if (r.top < vy) r.top = vy;
+   if (r.right > vx + vw) r.right = vx + vw;
+   if (r.bottom > vy + vh) r.bottom = vy + vh;
+   int width = r.right - r.left, height = r.bottom - r.top;
+   if (width < 16 || height < 16) return;
+   
+   HDC dc = nullptr;
+   HBITMAP bitmap = nullptr;
+   uint32_t *pixels = nullptr;
+   if (createDibDc(width, height, dc, bitmap, pixels)) {
+      HDC screen = GetDC(NULL);
+      BitBlt(dc, 0, 0, width, height, screen, r.left, r.top, SRCCOPY);
+      ReleaseDC(NULL, screen);
+      GdiFlush();
+      size_t first = out.size();
+      detectTargets(pixels, width, height, r.left, r.top, out);
+      dropSurfaceTargets(out, first);
+   }
+   if (bitmap) DeleteObject(bitmap);
+   if (dc) DeleteDC(dc);
+}
+
+// Publishes a freshly built index into the spare slot
+static void publishTargets(const std::vector<RECT> &rects) {
+   const TargetIndex *current = g_targetOwned.index.load();
+   TargetIndex &spare = (current == &g_targetSlots[0]) ? g_targetSlots[1] : g_targetSlots[0];
+   
+   // The physics thread may still hold the spare from before the last publish;
+   // wait until it has picked up the current one (it does so every tick) or
+   // has parked, which drops its reference
+   while (g_physicsOwned.targetSeen.load(std::memory_order_acquire) != current && !g_physicsOwned.parked.load() && g_control.running.load()) {
+      if (WaitForSingleObject(g_shutdownEvent, 1) == WAIT_OBJECT_0) return;
+   }
+   
+   buildTargetIndex(spare, rects);
+   g_targetOwned.index.store(&spare, std::memory_order_release);
+   wakePhysics(); // magnetism may now have somewhere to settle
+}
+
+// Target thread: rebuilds the index whenever the foreground window changes,
+// falling back to screenshot detection where UI Automation sees nothing
+void targetsLoop() {
+   HRESULT co = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+   IUIAutomation *uia = nullptr;
+   CoCreateInstance(__uuidof(CUIAutomation), NULL, CLSCTX_INPROC_SERVER, __uuidof(IUIAutomation),
+      reinterpret_cast<void **>(&uia));
+   
+   std::vector<RECT> rects;
+   HANDLE waits[2] = { g_targetsDirty, g_shutdownEvent };
+   while (uia && WaitForMultipleObjects(2, waits, FALSE, INFINITE) == WAIT_OBJECT_0) {
+      if (!targetsWanted()) continue;
+      HWND foreground = GetForegroundWindow();
+      collectTargets(uia, foreground, rects);
+      if (VISION_FALLBACK && rects.size() < VISION_MIN_UIA_TARGETS) detectWindowTargets(foreground, rects);
+      publishTargets(rects);
+      
+      if (g_hintMode.load() == HINT_PENDING) {
+         const HintSet &hints = publishHints(*g_targetOwned.index.load());
+         int expected = HINT_PENDING; // may have been cancelled meanwhile
+         g_hintMode.compare_exchange_strong(expected, hints.count > 0 ? HINT_ACTIVE : HINT_OFF);
+         notifyHints();
+      }
+   }
+   
+   if (uia) uia->Release();
+   if (SUCCEEDED(co)) CoUninitialize();
+}
+
+// --- Control pipe ---
+// A message-mode named pipe served by its own thread. Each request is one
+// message: a 1-byte opcode followed by a fixed little-endian payload. Each
+// reply starts with a 1-byte status (0 = ok) followed by the opcode's payload.
+//
+//   STATUS   -> u8 enabled, u8 buttons (bit0 left, bit1 right), i32 x, i32 y,
+//               f32 vx, f32 vy (pixels/sec)
+//   STATS    -> u64 ticks, u64 injectedEvents, u64 toggles, u64 hookReinstalls,
+//               u64 tickOverruns
+//   RELOAD   -> (none)  reinstalls the keyboard hook and re-resolves the profile
+//   ENABLE / DISABLE -> (none)
+//   WARP     i32 x, i32 y -> (none)
+//   QUIT     -> (none)
+//
+// Nothing here runs on the hook or physics threads: requests only read the
+// stats block and engine snapshot, or hand work over through atomics and
+// posted thread messages.
+enum ControlOp : uint8_t {
+   CONTROL_STATUS = 1,
+   CONTROL_STATS = 2,
+   CONTROL_RELOAD = 3,
+   CONTROL_ENABLE = 4,
+   CONTROL_DISABLE = 5,
+   CONTROL_WARP = 6,
+   CONTROL_QUIT = 7,
+};
+static constexpr uint8_t CONTROL_OK = 0;
+static constexpr uint8_t CONTROL_BAD_REQUEST = 1;
+static constexpr DWORD CONTROL_MAX_MESSAGE = 64;
+
+
+// Appends a trivially copyable value to a reply buffer
+template <typename T>
+static void putValue(uint8_t *buf, DWORD &len, T value) {
+   std::memcpy(buf + len, &value, sizeof(value));
+   len += sizeof(value);
+}
+
+// Handles one request message and fills the reply. Returns false to drop the client.
+static bool handleControlRequest(const uint8_t *req, DWORD reqLen, uint8_t *reply, DWORD &replyLen) {
+   replyLen = 0;
+   if (reqLen < 1) return false;
+   
+   putValue<uint8_t>(reply, replyLen, CONTROL_OK);
+   switch (req[0]) {
+      case CONTROL_STATUS: {
+         EngineSnapshot snap = g_snapshot.read();
+         bool on = (snap.hud & HUD_ENABLED) != 0;
+         POINT p = { (LONG)std::lround(snap.x), (LONG)std::lround(snap.y) };
+         if (!on) GetCursorPos(&p); // physics is parked; the mouse owns the cursor
+         uint8_t buttons = ((snap.hud & HUD_LEFT_HELD) ? 1 : 0) | ((snap.hud & HUD_RIGHT_HELD) ? 2 : 0);
+         putValue<uint8_t>(reply, replyLen, on ? 1 : 0);
+         putValue<uint8_t>(reply, replyLen, buttons);
+         putValue<int32_t>(reply, replyLen, p.x);
+         putValue<int32_t>(reply, replyLen, p.y);
+         putValue<float>(reply, replyLen, on ? snap.vx : 0.0f);
+         putValue<float>(reply, replyLen, on ? snap.vy : 0.0f);
+         break;
+      }
+      case CONTROL_STATS:
+         putValue<uint64_t>(reply, replyLen, g_stats.ticks.load(std::memory_order_relaxed));
+         putValue<uint64_t>(reply, replyLen, g_stats.injectedEvents.load(std::memory_order_relaxed));
+         putValue<uint64_t>(reply, replyLen, g_stats.toggles.load(std::memory_order_relaxed));
+         putValue<uint64_t>(reply, replyLen, g_stats.hookReinstalls.load(std::memory_order_relaxed));
+         putValue<uint64_t>(reply, replyLen, g_stats.tickOverruns.load(std::memory_order_relaxed));
+         break;
+      case CONTROL_RELOAD:
+         PostThreadMessageW(g_mainThreadId, WM_APP_REINSTALL_HOOK, 0, 0);
+         break;
+      case CONTROL_ENABLE:
+         setEnabled(true);
+         break;
+      case CONTROL_DISABLE:
+         setEnabled(false);
+         break;
+      case CONTROL_WARP: {
+         int32_t x, y;
+         if (reqLen != 1 + sizeof(x) + sizeof(y)) {
+            reply[0] = CONTROL_BAD_REQUEST;
+            break;
+         }
+         std::memcpy(&x, req + 1, sizeof(x));
+         std::memcpy(&y, req + 1 + sizeof(x), sizeof(y));
+         requestWarp(x, y);
+         break;
+      }
+      case CONTROL_QUIT:
+         g_control.running.store(false);
+         PostThreadMessageW(g_mainThreadId, WM_QUIT, 0, 0);
+         break;
+      default:
+         reply[0] = CONTROL_BAD_REQUEST;
+         break;
+   }
+   return true;
+}
+
+// Runs one overlapped pipe operation, waiting until it completes or shutdown is signalled
+static bool waitPipeIo(HANDLE pipe, OVERLAPPED *ov, BOOL started, DWORD *transferred) {
+   if (!started) {
+      DWORD err = GetLastError();
+      if (err == ERROR_PIPE_CONNECTED) return true;
+      if (err != ERROR_IO_PENDING) return false;
+   }
+   HANDLE waits[2] = { ov->hEvent, g_shutdownEvent };
+   if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0) {
+      CancelIoEx(pipe, ov);
+      GetOverlappedResult(pipe, ov, transferred, TRUE);
+      return false;
+   }
+   return GetOverlappedResult(pipe, ov, transferred, FALSE) != 0;
+}
+
+// Control pipe server thread: one client at a time, many requests per connection
+void controlLoop() {
+   HANDLE ioEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+   if (!ioEvent) return;
+   
+   while (g_control.running.load()) {
+      HANDLE pipe = CreateNamedPipeW(CONTROL_PIPE_NAME,
+         PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+         PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+         1, CONTROL_MAX_MESSAGE, CONTROL_MAX_MESSAGE, 0, NULL);
+      if (pipe == INVALID_HANDLE_VALUE) break;
+      
+      OVERLAPPED ov = {};
+      ov.hEvent = ioEvent;
+      DWORD n = 0;
+      ResetEvent(ioEvent);
+      bool connected = waitPipeIo(pipe, &ov, ConnectNamedPipe(pipe, &ov), &n);
+      
+      while (connected && g_control.running.load()) {
+         uint8_t req[CONTROL_MAX_MESSAGE];
+         uint8_t reply[CONTROL_MAX_MESSAGE];
+         DWORD reqLen = 0, replyLen = 0;
+         
+         ov = {};
+         ov.hEvent = ioEvent;
+         ResetEvent(ioEvent);
+         if (!waitPipeIo(pipe, &ov, ReadFile(pipe, req, sizeof(req), &reqLen, &ov), &reqLen)) break;
+         if (!handleControlRequest(req, reqLen, reply, replyLen)) break;
+         
+         ov = {};
+         ov.hEvent = ioEvent;
+         ResetEvent(ioEvent);
+         if (!waitPipeIo(pipe, &ov, WriteFile(pipe, reply, replyLen, &n, &ov), &n)) break;
+      }
+      
+      DisconnectNamedPipe(pipe);
+      CloseHandle(pipe);
+   }
+   
+   CloseHandle(ioEvent);
+}
+
+// --- UI thread: status HUD and cursor overlay ---
+// Both are small layered, click-through, always-on-top windows drawn with
+// OpenGL into a DIB section (the software GDI-generic pixel format) and pushed
+// with UpdateLayeredWindow, so they need no GPU and work offscreen.
+struct GlSurface {
+   int width = 0;
+   int height = 0;
+   uint32_t *pixels = nullptr; // BGRA, bottom-up
+   HDC dc = nullptr;
+   HBITMAP bitmap = nullptr;
+   HGDIOBJ oldBitmap = nullptr;
+   HFONT font = nullptr;
+   HGLRC gl = nullptr;
+   GLuint fontLists = 0;
+};
 
-// Add these globals for tracking previous mouse-key state (for drag/cleanup)
-std::atomic<bool> g_prevLeft(false), g_prevRight(false);
+static bool createGlSurface(GlSurface &r, int width, int height, bool withFont) {
+   r.width = width;
+   r.height = height;
+   r.dc = CreateCompatibleDC(NULL);
+   if (!r.dc) return false;
+   
+   BITMAPINFO bmi = {};
+   bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+   bmi.bmiHeader.biWidth = width;
+   bmi.bmiHeader.biHeight = height;
+   bmi.bmiHeader.biPlanes = 1;
+   bmi.bmiHeader.biBitCount = 32;
+   bmi.bmiHeader.biCompression = BI_RGB;
+   void *bits = nullptr;
+   r.bitmap = CreateDIBSection(r.dc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+   if (!r.bitmap) return false;
+   r.pixels = static_cast<uint32_t *>(bits);
+   r.oldBitmap = SelectObject(r.dc, r.bitmap);
+   
+   PIXELFORMATDESCRIPTOR pfd = {};
+   pfd.nSize = sizeof(pfd);
+   pfd.nVersion = 1;
+   pfd.dwFlags = PFD_DRAW_TO_BITMAP | PFD_SUPPORT_OPENGL | PFD_SUPPORT_GDI;
+   pfd.iPixelType = PFD_TYPE_RGBA;
+   pfd.cColorBits = 32;
+   pfd.iLayerType = PFD_MAIN_PLANE;
+   int format = ChoosePixelFormat(r.dc, &pfd);
+   if (!format || !SetPixelFormat(r.dc, format, &pfd)) return false;
+   
+   r.gl = wglCreateContext(r.dc);
+   if (!r.gl || !wglMakeCurrent(r.dc, r.gl)) return false;
+   
+   if (withFont) {
+      r.font = CreateFontW(-13, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
+         OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, NONANTIALIASED_QUALITY, FIXED_PITCH | FF_MODERN, L"Consolas");
+      SelectObject(r.dc, r.font);
+      r.fontLists = glGenLists(96);
+      wglUseFontBitmapsW(r.dc, 32, 96, r.fontLists);
+   }
+   return true;
+}
 
-// Controller state
-std::atomic<bool> enabled(false);
-std::atomic<bool> running(true);
+static void destroyGlSurface(GlSurface &r) {
+   if (r.gl) {
+      wglMakeCurrent(r.dc, r.gl);
+      if (r.fontLists) glDeleteLists(r.fontLists, 96);
+      wglMakeCurrent(NULL, NULL);
+      wglDeleteContext(r.gl);
+   }
+   if (r.oldBitmap) SelectObject(r.dc, r.oldBitmap);
+   if (r.bitmap) DeleteObject(r.bitmap);
+   if (r.font) DeleteObject(r.font);
+   if (r.dc) DeleteDC(r.dc);
+   r = GlSurface();
+}
 
-// Low-level keyboard hook handle
-HHOOK g_hHook = nullptr;
+// Makes the surface current with a y-down pixel projection
+static void beginGlFrame(const GlSurface &r) {
+   wglMakeCurrent(r.dc, r.gl);
+   glViewport(0, 0, r.width, r.height);
+   glMatrixMode(GL_PROJECTION);
+   glLoadIdentity();
+   glOrtho(0, r.width, r.height, 0, -1, 1);
+   glMatrixMode(GL_MODELVIEW);
+   glLoadIdentity();
+}
 
-// Utility: send a mouse click (left or right). Single click: down then up.
-void sendMouseClick(bool left) {
-   INPUT inputs[2] = {};
-   ZeroMemory(inputs, sizeof(inputs));
-   inputs[0].type = INPUT_MOUSE;
-   inputs[1].type = INPUT_MOUSE;
-   if (left) {
-      inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
-      inputs[1].mi.dwFlags = MOUSEEVENTF_LEFTUP;
-   } else {
-      inputs[0].mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
-      inputs[1].mi.dwFlags = MOUSEEVENTF_RIGHTUP;
+static void drawGlText(const GlSurface &r, int x, int y, const char *text) {
+   glRasterPos2i(x, y);
+   glListBase(r.fontLists - 32);
+   glCallLists((GLsizei)std::strlen(text), GL_UNSIGNED_BYTE, text);
+}
+
+// Creates a hidden layered tool window for one of the surfaces. Surfaces are
+// kept out of screen capture so neither vision detection nor the lens sees
+// them; where the system cannot, vision masks them out instead.
+static HWND createLayeredWindow(HINSTANCE hInstance, const wchar_t *className, int width, int height) {
+   WNDCLASSEXW wcx = {};
+   wcx.cbSize = sizeof(wcx);
+   wcx.lpfnWndProc = DefWindowProcW;
+   wcx.hInstance = hInstance;
+   wcx.lpszClassName = className;
+   RegisterClassExW(&wcx);
+   HWND hwnd = CreateWindowExW(WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE,
+      className, className, WS_POPUP, 0, 0, width, height, NULL, NULL, hInstance, NULL);
+   if (hwnd && !SetWindowDisplayAffinity(hwnd, WDA_EXCLUDEFROMCAPTURE)) {
+      int count = g_capturedSurfaceCount.load();
+      if (count < MAX_CAPTURED_SURFACES) {
+         g_capturedSurfaces[count].store(hwnd);
+         g_capturedSurfaceCount.store(count + 1);
+      }
    }
-   SendInput(2, inputs, sizeof(INPUT));
+   return hwnd;
 }
 
-void sendMouseDown(bool left) {
-   INPUT input = {};
-   input.type = INPUT_MOUSE;
-   input.mi.dwFlags = left ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_RIGHTDOWN;
-   SendInput(1, &input, sizeof(INPUT));
+// Status HUD: redrawn only when the engine posts WM_APP_HUD_CHANGED
+struct Hud {
+   HWND hwnd = nullptr;
+   GlSurface surface;
+};
+
+// Renders one HUD frame for the given state into the DIB and presents it
+static void renderHud(const Hud &hud, uint32_t state) {
+   const GlSurface &r = hud.surface;
+   bool on = (state & HUD_ENABLED) != 0;
+   
+   beginGlFrame(r);
+   glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+   glClear(GL_COLOR_BUFFER_BIT);
+   
+   // Mode bar down the left edge
+   if (on) glColor3f(0.2f, 0.85f, 0.35f);
+   else glColor3f(0.45f, 0.45f, 0.5f);
+   glBegin(GL_QUADS);
+   glVertex2i(0, 0);
+   glVertex2i(6, 0);
+   glVertex2i(6, HUD_HEIGHT);
+   glVertex2i(0, HUD_HEIGHT);
+   glEnd();
+   
+   char drag[8] = "-";
+   if (state & (HUD_LEFT_HELD | HUD_RIGHT_HELD)) {
+      snprintf(drag, sizeof(drag), "%s%s", (state & HUD_LEFT_HELD) ? "L" : "", (state & HUD_RIGHT_HELD) ? "R" : "");
+   }
+   char line[32];
+   glColor3f(0.95f, 0.95f, 0.95f);
+   drawGlText(r, 14, 18, on ? "MOUSEKEYS  ON" : "MOUSEKEYS  OFF");
+   if (on) {
+      snprintf(line, sizeof(line), "%-5s  drag %s", (state & HUD_SLOW) ? "slow" : "fast", drag);
+      glColor3f(0.7f, 0.7f, 0.75f);
+      drawGlText(r, 14, 36, line);
+   }
+   glFinish();
+   GdiFlush();
+   
+   // Top-right corner of the primary monitor's work area
+   POINT origin = { 0, 0 };
+   MONITORINFO mi = {};
+   mi.cbSize = sizeof(mi);
+   GetMonitorInfoW(MonitorFromPoint(origin, MONITOR_DEFAULTTOPRIMARY), &mi);
+   POINT dst = { mi.rcWork.right - HUD_WIDTH - 12, mi.rcWork.top + 12 };
+   SIZE size = { HUD_WIDTH, HUD_HEIGHT };
+   POINT src = { 0, 0 };
+   BLENDFUNCTION blend = { AC_SRC_OVER, 0, HUD_OPACITY, 0 };
+   UpdateLayeredWindow(hud.hwnd, NULL, &dst, &size, r.dc, &src, 0, &blend, ULW_ALPHA);
 }
 
-void sendMouseUp(bool left) {
-   INPUT input = {};
-   input.type = INPUT_MOUSE;
-   input.mi.dwFlags = left ? MOUSEEVENTF_LEFTUP : MOUSEEVENTF_RIGHTUP;
-   SendInput(1, &input, sizeof(INPUT));
+// Cursor overlay: crosshair plus a fading trail of recent physics positions.
+// The trail is a UI-thread-local copy of what the physics thread pushed into
+// g_trailRing, so rendering never holds up physics.
+struct Overlay {
+   HWND hwnd = nullptr;
+   GlSurface surface;
+   bool shown = false;
+   TrailPoint trail[TRAIL_LENGTH]; // oldest first
+   int count = 0;
+};
+
+// Appends freshly produced positions, keeping the newest TRAIL_LENGTH
+static void collectTrail(Overlay &o) {
+   TrailPoint fresh[TRAIL_RING_SIZE];
+   uint32_t n = g_trailRing.drain(fresh, TRAIL_RING_SIZE);
+   for (uint32_t i = 0; i < n; ++i) {
+      if (o.count == TRAIL_LENGTH) {
+         std::memmove(o.trail, o.trail + 1, sizeof(TrailPoint) * (TRAIL_LENGTH - 1));
+         --o.count;
+      }
+      o.trail[o.count++] = fresh[i];
+   }
 }
 
-// Low-level keyboard hook procedure
-LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
-   if (nCode < 0) {
-      return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+// Renders one overlay frame. Returns true while the trail is still fading, i.e.
+// while another frame is needed.
+static bool renderOverlay(Overlay &o) {
+   collectTrail(o);
+   
+   if (!g_control.overlayOn.load() || !g_control.enabled.load() || o.count == 0) {
+      if (o.shown) ShowWindow(o.hwnd, SW_HIDE);
+      o.shown = false;
+      o.count = 0;
+      return false;
    }
    
-   KBDLLHOOKSTRUCT *kb = reinterpret_cast<KBDLLHOOKSTRUCT *>(lParam);
-   bool isDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
-   bool isUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
+   // Drop points that have fully faded, but always keep the newest for the crosshair
+   LONGLONG now = qpcNow();
+   LONGLONG fadeTicks = (LONGLONG)(TRAIL_FADE_S * (double)g_qpcFrequency);
+   int expired = 0;
+   while (expired < o.count - 1 && now - o.trail[expired].time > fadeTicks) ++expired;
+   if (expired) {
+      std::memmove(o.trail, o.trail + expired, sizeof(TrailPoint) * (o.count - expired));
+      o.count -= expired;
+   }
    
-   // Toggle on key down of Right Shift or Caps Lock
-   if (isDown && (kb->vkCode == VK_RSHIFT || kb->vkCode == VK_CAPITAL)) {
-      bool now = enabled.load();
-      enabled.store(!now);
-      
-      return 1;
+   const GlSurface &r = o.surface;
+   const TrailPoint &head = o.trail[o.count - 1];
+   float originX = head.x - OVERLAY_SIZE / 2;
+   float originY = head.y - OVERLAY_SIZE / 2;
+   
+   beginGlFrame(r);
+   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+   glClear(GL_COLOR_BUFFER_BIT);
+   
+   // Trail: one vertex/colour array upload and one draw call. Colours are
+   // pre-faded towards black, which becomes transparent below.
+   float vertices[TRAIL_LENGTH * 2];
+   float colors[TRAIL_LENGTH * 3];
+   for (int i = 0; i < o.count; ++i) {
+      float age = (float)(now - o.trail[i].time) / (float)g_qpcFrequency;
+      float fade = 1.0f - age / TRAIL_FADE_S;
+      if (fade < 0.0f) fade = 0.0f;
+      vertices[i * 2] = o.trail[i].x - originX;
+      vertices[i * 2 + 1] = o.trail[i].y - originY;
+      colors[i * 3] = 0.3f * fade;
+      colors[i * 3 + 1] = 0.8f * fade;
+      colors[i * 3 + 2] = 1.0f * fade;
    }
+   glLineWidth(2.0f);
+   glEnableClientState(GL_VERTEX_ARRAY);
+   glEnableClientState(GL_COLOR_ARRAY);
+   glVertexPointer(2, GL_FLOAT, 0, vertices);
+   glColorPointer(3, GL_FLOAT, 0, colors);
+   glDrawArrays(GL_LINE_STRIP, 0, o.count);
+   glDisableClientState(GL_COLOR_ARRAY);
+   glDisableClientState(GL_VERTEX_ARRAY);
    
-   // Map movement keys when controller is enabled
-   if (enabled.load()) {
-      // Update our internal key state and swallow movement keys and click keys
-      switch (kb->vkCode) {
-         case VK_UP:
-            if (isDown) key_up.store(true);
-            if (isUp) key_up.store(false);
-         return 1; // swallow when enabled
-         case VK_DOWN:
-            if (isDown) key_down.store(true);
-            if (isUp) key_down.store(false);
-         return 1;
-         case VK_LEFT:
-            if (isDown) key_left.store(true);
-            if (isUp) key_left.store(false);
-         return 1;
-         case VK_RIGHT:
-            if (isDown) key_right.store(true);
-            if (isUp) key_right.store(false);
-         return 1;
-         case 'K':
-            if (isDown) key_k.store(true);
-            if (isUp) key_k.store(false);
-            return 1;
-         case 'J':
-            if (isDown) key_j.store(true);
-            if (isUp) key_j.store(false);
-         return 1;
-         case 'H':
-            if (isDown) key_h.store(true);
-            if (isUp) key_h.store(false);
-         return 1;
-         case 'L':
-            if (isDown) key_l.store(true);
-            if (isUp) key_l.store(false);
-         return 1;
-         case LEFT_CLICK_KEY:
-            if (isDown) leftClickPressed.store(true);
-            if (isUp) leftClickPressed.store(false);
-         return 1;
-         case RIGHT_CLICK_KEY:
-            if (isDown) rightClickPressed.store(true);
-            if (isUp) rightClickPressed.store(false);
-         return 1;
-         case VK_LSHIFT:
-            if (isDown) shiftPressed.store(true);
-            if (isUp) shiftPressed.store(false);
-         return 1; // allow the key to pass through to other apps
-         default:
-         break;
+   // Crosshair with a gap in the middle so the hotspot pixel stays visible
+   float c = OVERLAY_SIZE / 2 + 0.5f;
+   glLineWidth(1.0f);
+   glColor3f(1.0f, 0.3f, 0.3f);
+   glBegin(GL_LINES);
+   glVertex2f(c - 14, c);
+   glVertex2f(c - 3, c);
+   glVertex2f(c + 3, c);
+   glVertex2f(c + 14, c);
+   glVertex2f(c, c - 14);
+   glVertex2f(c, c - 3);
+   glVertex2f(c, c + 3);
+   glVertex2f(c, c + 14);
+   glEnd();
+   glFinish();
+   GdiFlush();
+   
+   // Everything was drawn over black, so the brightest channel is a valid
+   // premultiplied alpha and black stays fully transparent
+   for (int i = 0; i < r.width * r.height; ++i) {
+      uint32_t p = r.pixels[i];
+      uint32_t b = p & 0xFF, g = (p >> 8) & 0xFF, rd = (p >> 16) & 0xFF;
+      uint32_t a = b > g ? b : g;
+      if (rd > a) a = rd;
+      r.pixels[i] = (p & 0x00FFFFFF) | (a << 24);
+   }
+   
+   POINT dst = { (LONG)std::lround(originX), (LONG)std::lround(originY) };
+   SIZE size = { OVERLAY_SIZE, OVERLAY_SIZE };
+   POINT src = { 0, 0 };
+   BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+   UpdateLayeredWindow(o.hwnd, NULL, &dst, &size, r.dc, &src, 0, &blend, ULW_ALPHA);
+   if (!o.shown) ShowWindow(o.hwnd, SW_SHOWNOACTIVATE);
+   o.shown = true;
+   
+   return o.count > 1;
+}
+
+// Magnifier lens: a small screen tile around the cursor, scaled up with SSE2
+// kernels into an opaque layered window. It refreshes only when the cursor
+// has moved, at most LENS_MAX_FPS times a second.
+static constexpr int LENS_SIZE = LENS_TILE * LENS_ZOOM;
+static constexpr int LENS_SOURCE = LENS_TILE + 1; // one extra column/row for bilinear
+
+struct Lens {
+   HWND hwnd = nullptr;
+   HDC captureDc = nullptr;
+   HBITMAP captureBitmap = nullptr;
+   uint32_t *capture = nullptr; // LENS_SOURCE x LENS_SOURCE, top-down BGRA
+   HDC lensDc = nullptr;
+   HBITMAP lensBitmap = nullptr;
+   uint32_t *pixels = nullptr; // LENS_SIZE x LENS_SIZE, top-down BGRA
+   bool shown = false;
+   POINT last = { -1, -1 };
+   LONGLONG lastCapture = 0;
+};
+
+// Nearest-neighbour: each source pixel becomes a LENS_ZOOM x LENS_ZOOM block.
+// One destination row is expanded with 4-wide broadcast stores and then copied
+// down for the rest of the block.
+static void scaleNearest(const uint32_t *src, int srcStride, uint32_t *dst) {
+   for (int y = 0; y < LENS_TILE; ++y) {
+      const uint32_t *in = src + y * srcStride;
+      uint32_t *row = dst + (y * LENS_ZOOM) * LENS_SIZE;
+      for (int x = 0; x < LENS_TILE; ++x) {
+         uint32_t *out = row + x * LENS_ZOOM;
+#ifdef MOUSEKEYS_SSE2
+         __m128i px4 = _mm_set1_epi32((int)in[x]);
+         for (int k = 0; k < LENS_ZOOM; k += 4) _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), px4);
+#else
+         for (int k = 0; k < LENS_ZOOM; ++k) out[k] = in[x];
+#endif
       }
-   } else {
-      key_up.store(false);
-      key_down.store(false);
-      key_left.store(false);
-      key_right.store(false);
-      key_k.store(false);
-      key_j.store(false);
-      key_h.store(false);
-      key_l.store(false);
-      shiftPressed.store(false);
+      for (int k = 1; k < LENS_ZOOM; ++k) {
+         std::memcpy(row + k * LENS_SIZE, row, sizeof(uint32_t) * LENS_SIZE);
+      }
+   }
+}
+
+// out[i] = (a[i] * (256 - w) + b[i] * w) >> 8 per channel, for n pixels
+static void lerpPixels(const uint32_t *a, const uint32_t *b, uint32_t w, uint32_t *out, int n) {
+   int i = 0;
+#ifdef MOUSEKEYS_SSE2
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i wb = _mm_set1_epi16((short)w);
+   const __m128i wa = _mm_set1_epi16((short)(256 - w));
+   for (; i + 4 <= n; i += 4) {
+      __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+      __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+      // Products stay below 2^16, so unsigned 16-bit lanes are enough
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+         _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+         _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+      __m128i packed = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), packed);
+   }
+#endif
+   for (; i < n; ++i) {
+      uint32_t r = 0;
+      for (int shift = 0; shift < 32; shift += 8) {
+         uint32_t ca = (a[i] >> shift) & 0xFF, cb = (b[i] >> shift) & 0xFF;
+         r |= ((ca * (256 - w) + cb * w) >> 8) << shift;
+      }
+      out[i] = r;
+   }
+}
+
+// Bilinear: destination sample k of each source pixel sits (k + 0.5) / LENS_ZOOM
+// of the way to its right/lower neighbour, which is why the capture has one
+// extra row and column.
+static uint32_t lensWeight(int k) {
+   return (uint32_t)((2 * k + 1) * 128 / LENS_ZOOM);
+}
+
+// Horizontal pass for one source row: each column of phase k is one blend of
+// the row with itself shifted by one pixel
+static void expandRowBilinear(const uint32_t *in, uint32_t *out) {
+   uint32_t blended[LENS_TILE];
+   for (int k = 0; k < LENS_ZOOM; ++k) {
+      lerpPixels(in, in + 1, lensWeight(k), blended, LENS_TILE);
+      for (int x = 0; x < LENS_TILE; ++x) out[x * LENS_ZOOM + k] = blended[x];
+   }
+}
+
+static void scaleBilinear(const uint32_t *src, int srcStride, uint32_t *dst) {
+   uint32_t upper[LENS_SIZE];
+   uint32_t lower[LENS_SIZE];
+   expandRowBilinear(src, upper);
+   for (int y = 0; y < LENS_TILE; ++y) {
+      expandRowBilinear(src + (y + 1) * srcStride, lower);
+      for (int k = 0; k < LENS_ZOOM; ++k) {
+         lerpPixels(upper, lower, lensWeight(k), dst + (y * LENS_ZOOM + k) * LENS_SIZE, LENS_SIZE);
+      }
+      std::memcpy(upper, lower, sizeof(upper));
+   }
+}
+
+static bool createLens(Lens &lens, HINSTANCE hInstance) {
+   lens.hwnd = createLayeredWindow(hInstance, L"MouseKeysLens", LENS_SIZE, LENS_SIZE);
+   if (!lens.hwnd) return false;
+   return createDibDc(LENS_SOURCE, LENS_SOURCE, lens.captureDc, lens.captureBitmap, lens.capture)
+      && createDibDc(LENS_SIZE, LENS_SIZE, lens.lensDc, lens.lensBitmap, lens.pixels);
+}
+
+static void destroyLens(Lens &lens) {
+   if (lens.captureBitmap) DeleteObject(lens.captureBitmap);
+   if (lens.captureDc) DeleteDC(lens.captureDc);
+   if (lens.lensBitmap) DeleteObject(lens.lensBitmap);
+   if (lens.lensDc) DeleteDC(lens.lensDc);
+   if (lens.hwnd) DestroyWindow(lens.hwnd);
+   lens.hwnd = nullptr;
+}
+
+// Updates the lens if it is visible and due. Returns true while a refresh is
+// still pending (the cursor moved before the rate cap allowed a capture).
+static bool updateLens(Lens &lens) {
+   bool visible = g_control.lensOn.load() && (g_snapshot.read().hud & (HUD_ENABLED | HUD_SLOW))
+      == (HUD_ENABLED | HUD_SLOW);
+   if (!visible) {
+      if (lens.shown) ShowWindow(lens.hwnd, SW_HIDE);
+      lens.shown = false;
+      lens.last = { -1, -1 };
+      return false;
    }
    
-   // If not enabled, or other keys, pass through
-   return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+   POINT cursor;
+   if (!GetCursorPos(&cursor)) return false;
+   if (lens.shown && cursor.x == lens.last.x && cursor.y == lens.last.y) return false;
+   
+   LONGLONG now = qpcNow();
+   if (lens.shown && now - lens.lastCapture < g_qpcFrequency / LENS_MAX_FPS) return true;
+   lens.lastCapture = now;
+   lens.last = cursor;
+   
+   // Capture and scale the tile centred on the cursor's pixel
+   HDC screen = GetDC(NULL);
+   BitBlt(lens.captureDc, 0, 0, LENS_SOURCE, LENS_SOURCE, screen,
+      cursor.x - LENS_TILE / 2, cursor.y - LENS_TILE / 2, SRCCOPY);
+   ReleaseDC(NULL, screen);
+   GdiFlush();
+   if (LENS_BILINEAR) scaleBilinear(lens.capture, LENS_SOURCE, lens.pixels);
+   else scaleNearest(lens.capture, LENS_SOURCE, lens.pixels);
+   
+   // Outline the hotspot pixel
+   int c0 = (LENS_TILE / 2) * LENS_ZOOM - 1, c1 = c0 + LENS_ZOOM + 1;
+   for (int i = c0; i <= c1; ++i) {
+      lens.pixels[c0 * LENS_SIZE + i] = lens.pixels[c1 * LENS_SIZE + i] = 0xFFFF3030;
+      lens.pixels[i * LENS_SIZE + c0] = lens.pixels[i * LENS_SIZE + c1] = 0xFFFF3030;
+   }
+   
+   // Below-right of the cursor, flipped to the other side near the screen edge
+   int vx = GetSystemMetrics(SM_XVIRTUALSCREEN), vy = GetSystemMetrics(SM_YVIRTUALSCREEN);
+   int vw = GetSystemMetrics(SM_CXVIRTUALSCREEN), vh = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+   POINT dst = { cursor.x + 24, cursor.y + 24 };
+   if (dst.x + LENS_SIZE > vx + vw) dst.x = cursor.x - 24 - LENS_SIZE;
+   if (dst.y + LENS_SIZE > vy + vh) dst.y = cursor.y - 24 - LENS_SIZE;
+   SIZE size = { LENS_SIZE, LENS_SIZE };
+   POINT src = { 0, 0 };
+   BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, 0 };
+   UpdateLayeredWindow(lens.hwnd, NULL, &dst, &size, lens.lensDc, &src, 0, &blend, ULW_ALPHA);
+   if (!lens.shown) ShowWindow(lens.hwnd, SW_SHOWNOACTIVATE);
+   lens.shown = true;
+   return false;
 }
 
-// Physics & cursor movement loop that runs in its own thread
-void physicsLoop() {
-   // Get initial cursor position
-   POINT p;
-   if (!GetCursorPos(&p)) {
-      p.x = GetSystemMetrics(SM_CXSCREEN) / 2;
-      p.y = GetSystemMetrics(SM_CYSCREEN) / 2;
+// Hint labels: GDI text boxes on the targets' top-left corners, drawn into one
+// layered window spanning their bounding box. Redrawn only when hint mode
+// starts, ends or narrows to a first letter.
+struct HintOverlay {
+   HWND hwnd = nullptr;
+   HDC dc = nullptr;
+   HBITMAP bitmap = nullptr;
+   uint32_t *pixels = nullptr;
+   int width = 0, height = 0; // DIB size; grows as needed
+   HFONT font = nullptr;
+   HBRUSH brush = nullptr;
+   SIZE label = { 0, 0 }; // size of one label box
+   bool shown = false;
+};
+
+static bool createHintOverlay(HintOverlay &h, HINSTANCE hInstance) {
+   h.hwnd = createLayeredWindow(hInstance, L"MouseKeysHints", 1, 1);
+   if (!h.hwnd) return false;
+   h.font = CreateFontW(-12, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
+      OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, NONANTIALIASED_QUALITY, FIXED_PITCH | FF_MODERN, L"Consolas");
+   h.brush = CreateSolidBrush(RGB(255, 214, 64));
+   if (!h.font || !h.brush) return false;
+   
+   HDC screen = GetDC(NULL);
+   HGDIOBJ old = SelectObject(screen, h.font);
+   GetTextExtentPoint32W(screen, L"MM", 2, &h.label);
+   SelectObject(screen, old);
+   ReleaseDC(NULL, screen);
+   h.label.cx += 6;
+   h.label.cy += 2;
+   return true;
+}
+
+static void destroyHintOverlay(HintOverlay &h) {
+   if (h.bitmap) DeleteObject(h.bitmap);
+   if (h.dc) DeleteDC(h.dc);
+   if (h.font) DeleteObject(h.font);
+   if (h.brush) DeleteObject(h.brush);
+   if (h.hwnd) DestroyWindow(h.hwnd);
+   h = HintOverlay();
+}
+
+static void drawHints(HintOverlay &h, const HintSet &hints) {
+   int prefix = g_hookOwned.hintPrefix.load();
+   RECT bounds = { LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN };
+   int count = (g_hintMode.load() == HINT_ACTIVE) ? hints.count : 0;
+   auto visible = [&](int i) { return prefix < 0 || hints.labels[i][0] == HINT_ALPHABET[prefix]; };
+   for (int i = 0; i < count; ++i) {
+      if (!visible(i)) continue;
+      const RECT &r = hints.rects[i];
+      if (r.left < bounds.left) bounds.left = r.left;
+      if (r.top < bounds.top) bounds.top = r.top;
+      if (r.left + h.label.cx > bounds.right) bounds.right = r.left + h.label.cx;
+      if (r.top + h.label.cy > bounds.bottom) bounds.bottom = r.top + h.label.cy;
+   }
+   if (bounds.left > bounds.right) {
+      if (h.shown) ShowWindow(h.hwnd, SW_HIDE);
+      h.shown = false;
+      return;
    }
    
-   // Vars initialize/reinitialize
-   double px = (double)p.x;
-   double py = (double)p.y;
-   // double vx = 0.0;
-   // double vy = 0.0;
-   float dx = 0.0f;
-   float dy = 0.0f;
+   int width = bounds.right - bounds.left, height = bounds.bottom - bounds.top;
+   if (width > h.width || height > h.height) {
+      if (h.bitmap) DeleteObject(h.bitmap);
+      if (h.dc) DeleteDC(h.dc);
+      h.width = width > h.width ? width : h.width;
+      h.height = height > h.height ? height : h.height;
+      if (!createDibDc(h.width, h.height, h.dc, h.bitmap, h.pixels)) {
+         h.width = h.height = 0;
+         return;
+      }
+      SelectObject(h.dc, h.font);
+      SetBkMode(h.dc, TRANSPARENT);
+      SetTextColor(h.dc, RGB(0, 0, 0));
+   }
+   for (int y = 0; y < height; ++y) std::memset(h.pixels + (size_t)y * h.width, 0, sizeof(uint32_t) * width);
    
-   using clock = std::chrono::high_resolution_clock;
-   auto last = clock::now();
-   const double targetDt = 1.0 / UPDATES_PER_SEC;
+   // GDI leaves alpha at zero, so each box is made opaque after drawing
+   for (int i = 0; i < count; ++i) {
+      if (!visible(i)) continue;
+      RECT box = { hints.rects[i].left - bounds.left, hints.rects[i].top - bounds.top, 0, 0 };
+      box.right = box.left + h.label.cx;
+      box.bottom = box.top + h.label.cy;
+      FillRect(h.dc, &box, h.brush);
+      wchar_t text[2] = { (wchar_t)(hints.labels[i][0] - 'a' + 'A'), (wchar_t)(hints.labels[i][1] - 'a' + 'A') };
+      TextOutW(h.dc, box.left + 3, box.top + 1, text, 2);
+   }
+   GdiFlush();
+   for (int i = 0; i < count; ++i) {
+      if (!visible(i)) continue;
+      int x0 = hints.rects[i].left - bounds.left, y0 = hints.rects[i].top - bounds.top;
+      for (int y = y0; y < y0 + h.label.cy; ++y) {
+         uint32_t *row = h.pixels + (size_t)y * h.width;
+         for (int x = x0; x < x0 + h.label.cx; ++x) row[x] |= 0xFF000000u;
+      }
+   }
    
-   while (running.load()) {
-      auto now = clock::now();
-      std::chrono::duration<double> elapsed = now - last;
-      double dt = elapsed.count();
+   POINT dst = { bounds.left, bounds.top };
+   SIZE size = { width, height };
+   POINT src = { 0, 0 };
+   BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, 0 };
+   UpdateLayeredWindow(h.hwnd, NULL, &dst, &size, h.dc, &src, 0, &blend, ULW_ALPHA);
+   if (!h.shown) ShowWindow(h.hwnd, SW_SHOWNOACTIVATE);
+   h.shown = true;
+}
 
-      if (dt < 1e-9) dt = targetDt;
-      
-      // Clamp dt to avoid huge jumps
-      if (dt > 0.05) dt = 0.05;
-      last = now;
+static void renderHints(HintOverlay &h) {
+   // Pin the published set, re-checking it was not replaced before the pin landed
+   const HintSet *hints;
+   do {
+      hints = g_targetOwned.hints.load();
+      g_uiOwned.hintsReading.store(hints);
+   } while (g_targetOwned.hints.load() != hints);
+   drawHints(h, *hints);
+   g_uiOwned.hintsReading.store(nullptr);
+}
+
+Hud g_hud;
+Overlay g_overlay;
+Lens g_lens;
+HintOverlay g_hintOverlay;
+
+// UI thread. Sleeps until the engine posts something; while the overlay or
+// lens has work it renders one frame per display refresh (DwmFlush), then parks
+// again by setting g_uiOwned.idle. uiReady is signalled once startup is done.
+void uiLoop(HINSTANCE hInstance, HANDLE uiReady) {
+   MSG msg;
+   PeekMessageW(&msg, NULL, 0, 0, PM_NOREMOVE); // make sure the thread has a queue
+   
+   if (SHOW_HUD) {
+      g_hud.hwnd = createLayeredWindow(hInstance, L"MouseKeysHud", HUD_WIDTH, HUD_HEIGHT);
+      if (g_hud.hwnd && createGlSurface(g_hud.surface, HUD_WIDTH, HUD_HEIGHT, true)) {
+         renderHud(g_hud, g_snapshot.read().hud);
+         ShowWindow(g_hud.hwnd, SW_SHOWNOACTIVATE);
+      } else {
+         destroyGlSurface(g_hud.surface);
+         if (g_hud.hwnd) DestroyWindow(g_hud.hwnd);
+         g_hud.hwnd = nullptr;
+      }
+   }
+   
+   g_overlay.hwnd = createLayeredWindow(hInstance, L"MouseKeysOverlay", OVERLAY_SIZE, OVERLAY_SIZE);
+   if (g_overlay.hwnd && !createGlSurface(g_overlay.surface, OVERLAY_SIZE, OVERLAY_SIZE, false)) {
+      destroyGlSurface(g_overlay.surface);
+      DestroyWindow(g_overlay.hwnd);
+      g_overlay.hwnd = nullptr;
+   }
+   
+   if (!createLens(g_lens, hInstance)) destroyLens(g_lens);
+   if (!createHintOverlay(g_hintOverlay, hInstance)) destroyHintOverlay(g_hintOverlay);
+   
+   g_uiOwned.threadId.store(GetCurrentThreadId());
+   SetEvent(uiReady);
+   
+   bool animating = false;
+   for (;;) {
+      if (!animating) WaitMessage();
       
-      // If control enabled
-      if (enabled.load()) {
-         // Reinitialize vectors so cursor stops moving when no dir is pressed
-         dx = 0.0f;
-         dy = 0.0f;
-         
-         // Gather direction from key states
-         if (key_up.load() || key_k.load())    dy -= 1.0f;
-         if (key_down.load() || key_j.load())  dy += 1.0f;
-         if (key_left.load() || key_h.load())  dx -= 1.0f;
-         if (key_right.load() || key_l.load()) dx += 1.0f;
-         
-         // Normalize so diagonal isn't faster
-         float speed = std::hypot(dx, dy);
-         if (speed > 0.0f) {
-            dx /= speed;
-            dy /= speed;
-         }
-         
-         // // Apply acceleration
-         // vx += dx * ACCEL_PIX_PER_S2 * dt;
-         // vy += dy * ACCEL_PIX_PER_S2 * dt;
-         
-         // // Apply exponential friction
-         // float decay = std::expf(-FRICTION_PER_S * (float)dt);
-         // vx *= decay;
-         // vy *= decay;
-         
-         // // Clamp speed
-         // double speed = std::hypot(vx, vy);
-         // if (speed > MAX_SPEED_PIX_PER_S) {
-         //   double s = MAX_SPEED_PIX_PER_S / speed;
-         //   vx *= s;
-         //   vy *= s;
-         // }
-         
-         // // Integrate
-         // px += vx * dt;
-         // py += vy * dt;
-         
-         // Vanilla speed calcs w/ speed modifier
-         float speedMult = shiftPressed.load() ? 0.5f : 1.0f;
-         float move = MAX_SPEED_PIX_PER_S * speedMult * (float)dt;
-         px += dx * move;
-         py += dy * move;
-         
-         // Clamp to screen bounds
-         int screenW = GetSystemMetrics(SM_CXSCREEN);
-         int screenH = GetSystemMetrics(SM_CYSCREEN);
-         if (px < 0.0) {
-            px = 0.0;
-            //vx = 0.0;
-         }
-         if (py < 0.0) {
-            py = 0.0;
-            //vy = 0.0;
-         }
-         if (px > screenW - 1) {
-            px = screenW - 1;
-            //vx = 0.0;
-         }
-         if (py > screenH - 1) {
-            py = screenH - 1;
-            //vy = 0.0;
-         }
-         
-         // Move cursor
-         SetCursorPos((int)std::lround(px), (int)std::lround(py));
-         
-         // Look for key clicks and enable dragging
-         bool prevLeft = g_prevLeft.load();
-         bool prevRight = g_prevRight.load();
-         bool curLeft = leftClickPressed.load();
-         bool curRight = rightClickPressed.load();
-         if (curLeft && !prevLeft) {
-            sendMouseDown(true); // start a drag (mouse button down)
-         }
-         if (!curLeft && prevLeft) {
-            sendMouseUp(true); // end drag (mouse button up)
-         }
-         if (curRight && !prevRight) {
-            sendMouseDown(false);
-         }
-         if (!curRight && prevRight) {
-            sendMouseUp(false);
+      while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
+         if (msg.message == WM_QUIT) goto done;
+         if (msg.hwnd == NULL && msg.message == WM_APP_HUD_CHANGED) {
+            if (g_hud.hwnd) renderHud(g_hud, g_snapshot.read().hud);
+            animating = true; // enabled may have changed; let the overlay re-evaluate
+         } else if (msg.hwnd == NULL && msg.message == WM_APP_UI_WAKE) {
+            animating = true;
+         } else if (msg.hwnd == NULL && msg.message == WM_APP_HINTS_CHANGED) {
+            if (g_hintOverlay.hwnd) renderHints(g_hintOverlay);
+         } else {
+            DispatchMessageW(&msg);
          }
-         
-         g_prevLeft.store(curLeft);
-         g_prevRight.store(curRight);
+      }
+      
+      if (!animating) continue;
+      bool overlayBusy = g_overlay.hwnd && renderOverlay(g_overlay);
+      bool lensBusy = g_lens.hwnd && updateLens(g_lens);
+      animating = overlayBusy || lensBusy;
+      if (animating) {
+         DwmFlush();
       } else {
-         // // If disabled, slowly zero velocity (so it doesn't fling when re-enabled)
-         // vx *= 0.6;
-         // vy *= 0.6;
-         
-         // If disabled (vanilla), set velocity to zero << *for some reason this isn't necessary*
-         // dx *= 0.0;
-         // dy *= 0.0;
-         
-         // Keeps px/py synced with current cursor location (when user moves with mouse)
-         POINT curp;
-         if (GetCursorPos(&curp)) {
-            px = (double)curp.x;
-            py = (double)curp.y;
+         // Park, then re-check for work that raced with the decision to park
+         g_uiOwned.idle.store(true);
+         POINT cursor;
+         bool lensStale = g_lens.shown && GetCursorPos(&cursor)
+            && (cursor.x != g_lens.last.x || cursor.y != g_lens.last.y);
+         bool trailPending = g_trailRing.head.load() != g_trailRing.tail.load();
+         if ((trailPending || lensStale) && g_uiOwned.idle.exchange(false)) animating = true;
+      }
+   }
+   
+done:
+   g_uiOwned.threadId.store(0);
+   destroyHintOverlay(g_hintOverlay);
+   destroyLens(g_lens);
+   destroyGlSurface(g_overlay.surface);
+   if (g_overlay.hwnd) DestroyWindow(g_overlay.hwnd);
+   destroyGlSurface(g_hud.surface);
+   if (g_hud.hwnd) DestroyWindow(g_hud.hwnd);
+}
+
+// --- Metrics exporter ---
+// Periodically renders the stats block in Prometheus text exposition format
+// and publishes it with a write-to-temp + atomic rename, so a scraper never
+// sees a half-written file.
+static void appendMetric(std::string &out, const char *name, const char *type, const char *help, uint64_t value) {
+   char line[256];
+   snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n%s %llu\n",
+      name, help, name, type, name, (unsigned long long)value);
+   out += line;
+}
+
+static void appendHistogram(std::string &out, const char *name, const char *help, const LatencyHistogram &h) {
+   char line[256];
+   snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+   out += line;
+   
+   uint64_t cumulative = 0;
+   for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+      cumulative += h.counts[i].load(std::memory_order_relaxed);
+      if (i < LatencyHistogram::BUCKETS - 1) {
+         snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %llu\n",
+            name, LatencyHistogram::BOUNDS_NS[i] / 1e9, (unsigned long long)cumulative);
+      } else {
+         snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+      }
+      out += line;
+   }
+   snprintf(line, sizeof(line), "%s_sum %.9f\n%s_count %llu\n",
+      name, h.sumNs.load(std::memory_order_relaxed) / 1e9, name, (unsigned long long)cumulative);
+   out += line;
+}
+
+static std::string renderMetrics() {
+   std::string out;
+   out.reserve(2048);
+   EngineSnapshot snap = g_snapshot.read();
+   bool on = (snap.hud & HUD_ENABLED) != 0;
+   appendMetric(out, "mousekeys_enabled", "gauge", "1 while keyboard control is enabled.", on ? 1 : 0);
+   appendMetric(out, "mousekeys_cursor_speed_pixels_per_second", "gauge", "Cursor speed over the last physics tick.",
+      on ? (uint64_t)std::lround(std::hypot(snap.vx, snap.vy)) : 0);
+   appendMetric(out, "mousekeys_ticks_total", "counter", "Physics ticks run.",
+      g_stats.ticks.load(std::memory_order_relaxed));
+   appendMetric(out, "mousekeys_tick_overruns_total", "counter", "Physics ticks that started more than a period late.",
+      g_stats.tickOverruns.load(std::memory_order_relaxed));
+   appendMetric(out, "mousekeys_injected_events_total", "counter", "Mouse button events injected with SendInput.",
+      g_stats.injectedEvents.load(std::memory_order_relaxed));
+   appendMetric(out, "mousekeys_toggles_total", "counter", "Enable/disable transitions.",
+      g_stats.toggles.load(std::memory_order_relaxed));
+   appendMetric(out, "mousekeys_hook_reinstalls_total", "counter", "Keyboard hook reinstalls.",
+      g_stats.hookReinstalls.load(std::memory_order_relaxed));
+   appendMetric(out, "mousekeys_dropped_key_events_total", "counter", "Key events dropped because the event ring was full.",
+      g_stats.droppedKeyEvents.load(std::memory_order_relaxed));
+   appendHistogram(out, "mousekeys_hook_latency_seconds", "Time spent inside the keyboard hook per keystroke.",
+      g_stats.hookLatency);
+   appendHistogram(out, "mousekeys_hook_transition_seconds", "Enable/disable until the keyboard hook was installed or removed.",
+      g_stats.hookTransition);
+   return out;
+}
+
+// Writes the metrics file every METRICS_INTERVAL_MS until shutdown
+void metricsLoop() {
+   std::wstring path = exeDirectory() + METRICS_FILE_NAME;
+   std::wstring tmpPath = path + L".tmp";
+   
+   do {
+      std::string text = renderMetrics();
+      HANDLE file = CreateFileW(tmpPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+      if (file == INVALID_HANDLE_VALUE) continue;
+      
+      DWORD written = 0;
+      BOOL ok = WriteFile(file, text.data(), (DWORD)text.size(), &written, NULL);
+      CloseHandle(file);
+      if (ok && written == text.size()) {
+         MoveFileExW(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+      }
+   } while (WaitForSingleObject(g_shutdownEvent, METRICS_INTERVAL_MS) == WAIT_TIMEOUT);
+}
+
+// --- Soak simulator ---
+// `mousekeys.exe --soak <hours>` runs that much synthetic usage through the
+// real hook body and physics tick at full speed against a virtual desktop (no
+// hooks, windows, plugins or injected input), then writes SOAK_REPORT_NAME
+// next to the executable. Exit code 0 means every check passed.
+struct SoakDesktop {
+   int width = 1920, height = 1080;
+   POINT cursor = { 960, 540 };
+   bool buttons[2] = {}; // left, right
+   uint64_t strayUps = 0;    // button released while already up
+   uint64_t doubleDowns = 0; // button pressed while already down
+};
+SoakDesktop g_soak;
+
+static const Desktop SOAK_DESKTOP = {
+   [](POINT *p) { *p = g_soak.cursor; return true; },
+   [](int x, int y) { g_soak.cursor = { x, y }; },
+   [](bool left) {
+      bool &down = g_soak.buttons[left ? 0 : 1];
+      if (down) ++g_soak.doubleDowns;
+      down = true;
+   },
+   [](bool left) {
+      bool &down = g_soak.buttons[left ? 0 : 1];
+      if (!down) ++g_soak.strayUps;
+      down = false;
+   },
+   [](bool left) {
+      if (g_soak.buttons[left ? 0 : 1]) ++g_soak.doubleDowns;
+   },
+   [](int index) {
+      if (index == SM_CXSCREEN) return g_soak.width;
+      if (index == SM_CYSCREEN) return g_soak.height;
+      return GetSystemMetrics(index);
+   },
+};
+
+// Feeds one synthetic key transition through the hook body
+static void soakKey(int vk, bool down, uint64_t tick) {
+   KBDLLHOOKSTRUCT kb = {};
+   kb.vkCode = (DWORD)vk;
+   kb.time = (DWORD)(tick * 1000 / UPDATES_PER_SEC);
+   handleKeyboardHook(HC_ACTION, down ? WM_KEYDOWN : WM_KEYUP, reinterpret_cast<LPARAM>(&kb));
+}
+
+static void soakToggle(uint64_t tick) {
+   soakKey(VK_CAPITAL, true, tick);
+   soakKey(VK_CAPITAL, false, tick);
+}
+
+static uint64_t soakRandom(uint64_t &state) {
+   state ^= state << 13;
+   state ^= state >> 7;
+   state ^= state << 17;
+   return state;
+}
+
+static SIZE_T privateBytes() {
+   PROCESS_MEMORY_COUNTERS_EX pmc = {};
+   pmc.cb = sizeof(pmc);
+   GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS *>(&pmc), sizeof(pmc));
+   return pmc.PrivateUsage;
+}
+
+int runSoak(double hours) {
+   // Keys the synthetic user presses: movement, clicks, slow, toggle. Mode keys
+   // are left out since their consumers (UI, target threads) are not running.
+   static constexpr int KEYS[] = {
+      VK_UP, VK_DOWN, VK_LEFT, VK_RIGHT, 'H', 'J', 'K', 'L', LEFT_CLICK_KEY, RIGHT_CLICK_KEY, VK_LSHIFT, VK_CAPITAL,
+   };
+   static constexpr int KEY_COUNT = sizeof(KEYS) / sizeof(KEYS[0]);
+   static constexpr uint64_t PROBE_EVERY = 10ull * 60 * UPDATES_PER_SEC; // one drift probe per virtual 10 minutes
+   static constexpr uint64_t MEMORY_EVERY = 3600ull * UPDATES_PER_SEC;
+   const double dt = 1.0 / UPDATES_PER_SEC;
+   const uint64_t total = (uint64_t)(hours * 3600.0 * UPDATES_PER_SEC);
+   
+   uint64_t rng = 0x9E3779B97F4A7C15ull;
+   uint64_t releaseAt[KEY_COUNT] = {}; // 0 = not held
+   uint64_t keyEvents = 0, stuckTicks = 0, desyncTicks = 0, outOfBounds = 0, nonFinite = 0, probes = 0;
+   uint32_t ringHighWater = 0;
+   double maxCursorError = 0.0, maxDrift = 0.0;
+   SIZE_T memStart = 0, memPeak = 0, memEnd = 0;
+   
+   PhysicsState st;
+   st.px = g_soak.cursor.x;
+   st.py = g_soak.cursor.y;
+   LONGLONG wallStart = qpcNow();
+   
+   auto key = [&](int i, bool down, uint64_t tick) {
+      soakKey(KEYS[i], down, tick);
+      releaseAt[i] = down ? tick + 1 + soakRandom(rng) % (2 * UPDATES_PER_SEC) : 0;
+      ++keyEvents;
+   };
+   auto step = [&](uint64_t tick) {
+      uint32_t queued = g_keyEvents.head.load() - g_keyEvents.tail.load();
+      if (queued > ringHighWater) ringHighWater = queued;
+      physicsTick(st, dt, SOAK_DESKTOP);
+      
+      if (!std::isfinite(st.px) || !std::isfinite(st.py)) ++nonFinite;
+      if (g_soak.cursor.x < 0 || g_soak.cursor.y < 0 || g_soak.cursor.x >= g_soak.width
+         || g_soak.cursor.y >= g_soak.height) ++outOfBounds;
+      if (g_soak.buttons[0] != g_physicsOwned.prevLeft.load() || g_soak.buttons[1] != g_physicsOwned.prevRight.load()) ++desyncTicks;
+      if (!g_control.enabled.load() && (g_soak.buttons[0] || g_soak.buttons[1])) ++stuckTicks;
+      if (g_control.enabled.load()) {
+         double err = std::fmax(std::fabs(st.px - g_soak.cursor.x), std::fabs(st.py - g_soak.cursor.y));
+         if (err > maxCursorError) maxCursorError = err;
+      }
+      if (tick % MEMORY_EVERY == MEMORY_EVERY - 1) {
+         memEnd = privateBytes();
+         if (!memStart) memStart = memEnd; // first sample after an hour of warm-up
+         if (memEnd > memPeak) memPeak = memEnd;
+      }
+   };
+   
+   for (uint64_t tick = 0; tick < total; ++tick) {
+      // Drift probe: from the centre, hold Right then Left for the same time and
+      // check the cursor comes back to exactly where it started
+      if (tick % PROBE_EVERY == PROBE_EVERY - 1) {
+         for (int i = 0; i < KEY_COUNT; ++i) if (releaseAt[i]) key(i, false, tick);
+         if (!g_control.enabled.load()) soakToggle(tick);
+         requestWarp(g_soak.width / 2, g_soak.height / 2);
+         step(tick);
+         double startX = st.px;
+         for (int dir : { VK_RIGHT, VK_LEFT }) {
+            soakKey(dir, true, tick);
+            for (int n = 0; n < UPDATES_PER_SEC; ++n) step(tick);
+            soakKey(dir, false, tick);
+            step(tick);
          }
+         double drift = std::fabs(st.px - startX);
+         if (drift > maxDrift) maxDrift = drift;
+         ++probes;
       }
       
-      // Sleep to approximate target update rate (use high-res sleep)
-      std::this_thread::sleep_for(std::chrono::duration<double>(targetDt));
+      // Random presses (auto-repeat included), releases in any order, the
+      // occasional release of a key that was never pressed
+      uint64_t r = soakRandom(rng);
+      int i = (int)(r % KEY_COUNT);
+      if ((r >> 8) % 8 == 0) {
+         if (KEYS[i] == VK_CAPITAL) {
+            if ((r >> 16) % 64 == 0) soakToggle(tick);
+         } else if (!releaseAt[i] || (r >> 16) % 4 == 0) {
+            key(i, true, tick);
+         }
+      } else if ((r >> 8) % 512 == 1 && !releaseAt[i]) {
+         soakKey(KEYS[i], false, tick);
+      }
+      for (int k = 0; k < KEY_COUNT; ++k) {
+         if (releaseAt[k] && releaseAt[k] <= tick) key(k, false, tick);
+      }
+      
+      step(tick);
+   }
+   
+   // Wind down: release everything, turn control off and let one tick settle it
+   for (int i = 0; i < KEY_COUNT; ++i) if (releaseAt[i]) key(i, false, total);
+   if (g_control.enabled.load()) soakToggle(total);
+   step(total);
+   
+   double wallS = (double)(qpcNow() - wallStart) / (double)g_qpcFrequency;
+   long long memGrowth = memStart ? (long long)memEnd - (long long)memStart : 0;
+   bool pass = stuckTicks == 0 && desyncTicks == 0 && outOfBounds == 0 && nonFinite == 0
+      && g_soak.strayUps == 0 && g_soak.doubleDowns == 0 && g_soak.buttons[0] == false && g_soak.buttons[1] == false
+      && g_stats.droppedKeyEvents.load() == 0 && maxCursorError <= 0.5 && maxDrift < 1e-6
+      && memGrowth < SOAK_MAX_MEMORY_GROWTH;
+   
+   char report[2048];
+   snprintf(report, sizeof(report),
+      "virtual time        %.1f h (%llu ticks) in %.1f s\n"
+      "key events          %llu (toggles %llu, dropped %llu)\n"
+      "event ring peak     %u of %u\n"
+      "stuck-button ticks  %llu\n"
+      "button desyncs      %llu ticks, %llu stray ups, %llu double downs\n"
+      "out-of-bounds ticks %llu\n"
+      "non-finite ticks    %llu\n"
+      "max |px - cursor|   %.6f px\n"
+      "max drift           %.9f px over %llu round trips\n"
+      "private bytes       %llu -> %llu (peak %llu, growth %lld)\n"
+      "result              %s\n",
+      hours, (unsigned long long)total, wallS,
+      (unsigned long long)keyEvents, (unsigned long long)g_stats.toggles.load(),
+      (unsigned long long)g_stats.droppedKeyEvents.load(),
+      ringHighWater, KEY_EVENT_RING_SIZE,
+      (unsigned long long)stuckTicks,
+      (unsigned long long)desyncTicks, (unsigned long long)g_soak.strayUps, (unsigned long long)g_soak.doubleDowns,
+      (unsigned long long)outOfBounds,
+      (unsigned long long)nonFinite,
+      maxCursorError,
+      maxDrift, (unsigned long long)probes,
+      (unsigned long long)memStart, (unsigned long long)memEnd, (unsigned long long)memPeak, memGrowth,
+      pass ? "PASS" : "FAIL");
+   
+   std::wstring path = exeDirectory() + SOAK_REPORT_NAME;
+   HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file != INVALID_HANDLE_VALUE) {
+      DWORD written = 0;
+      WriteFile(file, report, (DWORD)std::strlen(report), &written, NULL);
+      CloseHandle(file);
    }
+   return pass ? 0 : 1;
 }
 
 // Minimal hidden window to keep message loop alive (hooks require a message loop in the thread)
@@ -341,7 +3583,7 @@ HWND createMessageWindow(HINSTANCE hInstance) {
       return hwnd;
 }
    
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int) {
    //// Optional: allocate console for debug output
    // AllocConsole();
    // FILE *f;
@@ -350,6 +3592,22 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
    // to quit.\n"; std::cout << "When enabled: Arrow keys or WASD move the
    // cursor. Z = left click, X = right click.\n"; std::cout << std::endl;
    
+   // Work in physical pixels so cursor positions, monitor rectangles and UI
+   // Automation bounding boxes all share one coordinate space
+   SetProcessDPIAware();
+   LARGE_INTEGER qpcFrequency;
+   QueryPerformanceFrequency(&qpcFrequency);
+   g_qpcFrequency = qpcFrequency.QuadPart;
+   
+   // Soak mode: simulated usage only, no hooks or windows
+   if (const char *soak = std::strstr(lpCmdLine, "--soak")) {
+      compileProfileCurves();
+      buildDirectionTable();
+      return runSoak(std::atof(soak + 6));
+   }
+   
+   g_mainThreadId = GetCurrentThreadId();
+   
    // Create message-only window (so hook thread has a message pump)
    HWND hwnd = createMessageWindow(hInstance);
    
@@ -361,33 +3619,98 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
       MessageBoxW(NULL, L"Failed to install keyboard hook. Exiting.",L"mousekeys", MB_ICONERROR);
       return 1;
    }
+   syncHook(); // starts disabled: trade the hook for the hotkey if allowed
       
+   // Track the foreground application for per-app profiles
+   HWINEVENTHOOK focusHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND,
+      NULL, onForegroundChanged, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+   refreshProfile();
+   
+   compileProfileCurves();
+   buildDirectionTable();
+   loadPlugins();
+   
    // Start physics thread
+   g_physicsWake = CreateEventW(NULL, FALSE, FALSE, NULL);
    std::thread phys(physicsLoop);
    
+   // Start control pipe server and metrics exporter
+   g_shutdownEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+   std::thread control(controlLoop);
+   std::thread metrics;
+   if (METRICS_FILE_NAME) metrics = std::thread(metricsLoop);
+   
+   // Start the click-target collector
+   g_targetsDirty = CreateEventW(NULL, FALSE, FALSE, NULL);
+   std::thread targets(targetsLoop);
+   invalidateTargets();
+   
+   // Start the HUD and cursor overlay on their own UI thread
+   HANDLE uiReady = CreateEventW(NULL, TRUE, FALSE, NULL);
+   std::thread ui(uiLoop, hInstance, uiReady);
+   
    // Simple message loop to keep process alive and handle hook/event dispatch
    MSG msg;
-   while (running.load() && GetMessage(&msg, NULL, 0, 0)) {
+   while (g_control.running.load() && GetMessage(&msg, NULL, 0, 0)) {
+      if (msg.hwnd == NULL && msg.message == WM_APP_REINSTALL_HOOK) {
+         // Windows silently drops low-level hooks that time out; re-arm on request
+         if (g_hHook) {
+            UnhookWindowsHookEx(g_hHook);
+            g_hHook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, NULL, 0);
+            g_stats.hookReinstalls.fetch_add(1, std::memory_order_relaxed);
+         }
+         syncHook();
+         refreshProfile();
+         continue;
+      }
+      if (msg.hwnd == NULL && msg.message == WM_APP_SYNC_HOOK) {
+         syncHook();
+         continue;
+      }
+      if (msg.hwnd == NULL && msg.message == WM_HOTKEY && msg.wParam == TOGGLE_HOTKEY_ID) {
+         setEnabled(true);
+         syncHook(); // hook first, so the Caps Lock fix-up below is not swallowed
+         restoreCapsLock();
+         continue;
+      }
       TranslateMessage(&msg);
       DispatchMessage(&msg);
    }
    
    // Cleanup
-   running.store(false);
+   g_control.running.store(false);
+   if (focusHook) UnhookWinEvent(focusHook);
    if (g_hHook) {
       UnhookWindowsHookEx(g_hHook);
       g_hHook = nullptr;
    }
+   if (g_mouseHook) UnhookWindowsHookEx(g_mouseHook);
+   if (g_hotkeyRegistered) UnregisterHotKey(NULL, TOGGLE_HOTKEY_ID);
 
-   // Wait for physics thread to finish
+   // Wait for physics and service threads to finish
+   SetEvent(g_physicsWake);
    if (phys.joinable()) phys.join();
+   unloadPlugins();
+   SetEvent(g_shutdownEvent);
+   if (control.joinable()) control.join();
+   if (metrics.joinable()) metrics.join();
+   if (targets.joinable()) targets.join();
+   CloseHandle(g_targetsDirty);
+   if (ui.joinable()) {
+      WaitForSingleObject(uiReady, INFINITE);
+      PostThreadMessageW(g_uiOwned.threadId.load(), WM_QUIT, 0, 0);
+      ui.join();
+   }
+   CloseHandle(uiReady);
+   CloseHandle(g_shutdownEvent);
+   CloseHandle(g_physicsWake);
    
    //// Free console optionally
    // FreeConsole();
 
    // After physics and hook cleanup (before return)
-   if (g_prevLeft.load()) sendMouseUp(true);
-   if (g_prevRight.load()) sendMouseUp(false);
+   if (g_physicsOwned.prevLeft.load()) sendMouseUp(true);
+   if (g_physicsOwned.prevRight.load()) sendMouseUp(false);
 
    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+mousekeys_plugin.h
+
+Stable C ABI for Better Mouse Keys plugins.
+
+A plugin is a DLL placed in the "plugins" folder next to the executable. At
+startup the host calls the exported mk_plugin_init() once; the plugin fills in
+an mk_plugin describing its callbacks. While control is enabled the host then
+calls each callback once per physics tick with the whole tick batched into an
+mk_tick, so the cost of crossing the module boundary is one indirect call per
+tick, not one per key event.
+
+Plugin kinds
+- Filter: sees the tick's key events and the resolved input (direction, speed,
+buttons) and may rewrite the input before movement is integrated.
+- Motion model: replaces the built-in integrator. It reads dir/speed/dt and
+writes the new sub-pixel position. Only the first loaded motion model is used.
+
+Rules
+- Callbacks run on the physics thread and must not block.
+- The mk_tick and its event array are only valid for the duration of the call.
+- New fields are only ever appended; MK_PLUGIN_ABI_VERSION is bumped when the
+layout of any struct below changes. The host still loads plugins built against
+an older version; the fields they do not know about stay zero.
+
+History
+- 1: initial version.
+- 2: mk_plugin.reset.
+*/
+
+#ifndef MOUSEKEYS_PLUGIN_H
+#define MOUSEKEYS_PLUGIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MK_PLUGIN_ABI_VERSION 2u
+
+#if defined(_WIN32)
+#define MK_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define MK_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* Actions a key can be bound to (values are part of the ABI) */
+enum {
+   MK_ACTION_NONE = 0,
+   MK_ACTION_UP = 1,
+   MK_ACTION_DOWN = 2,
+   MK_ACTION_LEFT = 3,
+   MK_ACTION_RIGHT = 4,
+   MK_ACTION_LEFT_CLICK = 5,
+   MK_ACTION_RIGHT_CLICK = 6,
+   MK_ACTION_SLOW = 7,
+   MK_ACTION_TOGGLE = 8,
+   MK_ACTION_TOGGLE_OVERLAY = 9,
+   MK_ACTION_TOGGLE_LENS = 10,
+   MK_ACTION_TOGGLE_MAGNET = 11,
+   MK_ACTION_HINT = 12,
+   MK_ACTION_UP_LEFT = 13,
+   MK_ACTION_UP_RIGHT = 14,
+   MK_ACTION_DOWN_LEFT = 15,
+   MK_ACTION_DOWN_RIGHT = 16,
+   MK_ACTION_AXIS_LOCK = 17,
+   MK_ACTION_ANGLE_SNAP = 18
+};
+
+/* mk_tick.buttons bits */
+#define MK_BUTTON_LEFT 1u
+#define MK_BUTTON_RIGHT 2u
+
+/* mk_plugin.kind bits */
+#define MK_PLUGIN_FILTER 1u
+#define MK_PLUGIN_MOTION 2u
+
+/* One key transition seen by the keyboard hook */
+typedef struct mk_key_event {
+   uint32_t vk;      /* Windows virtual-key code */
+   uint32_t action;  /* MK_ACTION_* */
+   uint32_t down;    /* 1 = pressed, 0 = released */
+   uint32_t time_ms; /* hook timestamp (milliseconds, wraps) */
+} mk_key_event;
+
+/* Everything a plugin sees for one physics tick */
+typedef struct mk_tick {
+   double dt;                  /* seconds since the previous tick */
+   double x, y;                /* sub-pixel cursor position (motion models write these) */
+   float dir_x, dir_y;         /* normalised held direction, zero when idle */
+   float speed;                /* pixels/sec for this tick after modifiers */
+   uint32_t buttons;           /* MK_BUTTON_* currently requested */
+   uint32_t event_count;       /* number of entries in events */
+   const mk_key_event *events; /* key events since the previous tick, in arrival order */
+} mk_tick;
+
+typedef void (*mk_tick_fn)(void *user, mk_tick *tick);
+
+typedef struct mk_plugin {
+   uint32_t abi_version; /* set to MK_PLUGIN_ABI_VERSION */
+   uint32_t kind;        /* MK_PLUGIN_* bits */
+   const char *name;
+   void *user;           /* passed back to every callback */
+   mk_tick_fn filter;    /* required when kind has MK_PLUGIN_FILTER */
+   mk_tick_fn motion;    /* required when kind has MK_PLUGIN_MOTION */
+   void (*shutdown)(void *user); /* optional */
+   /* Optional (ABI 2). Called on the physics thread once each time control is
+      turned off, so state such as velocity does not carry into the next enable. */
+   void (*reset)(void *user);
+} mk_plugin;
+
+/* Exported by every plugin. Return 0 on success; anything else skips the plugin. */
+typedef int (*mk_plugin_init_fn)(uint32_t host_abi_version, mk_plugin *out);
+#define MK_PLUGIN_INIT_SYMBOL "mk_plugin_init"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
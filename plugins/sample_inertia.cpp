@@ -0,0 +1,65 @@
+/*
+sample_inertia.cpp
+
+Sample Better Mouse Keys plugin: a motion model with acceleration, exponential
+friction and a speed cap, i.e. the "physics-style" movement sketched in the
+comments of main.cpp. Drop the built DLL into the "plugins" folder next to the
+executable to use it.
+*/
+
+#include <cmath>
+#include "../mousekeys_plugin.h"
+
+// --- Configuration (tweak to match feel) ---
+static constexpr double ACCEL_PIX_PER_S2 = 6000.0; // acceleration while a direction is held
+static constexpr double FRICTION_PER_S = 12.0; // exponential decay rate of velocity
+
+struct InertiaState {
+   double vx = 0.0;
+   double vy = 0.0;
+};
+
+static InertiaState g_state;
+
+static void inertiaMotion(void *user, mk_tick *tick) {
+   InertiaState *s = static_cast<InertiaState *>(user);
+   
+   // Apply acceleration towards the held direction
+   s->vx += tick->dir_x * ACCEL_PIX_PER_S2 * tick->dt;
+   s->vy += tick->dir_y * ACCEL_PIX_PER_S2 * tick->dt;
+   
+   // Apply exponential friction
+   double decay = std::exp(-FRICTION_PER_S * tick->dt);
+   s->vx *= decay;
+   s->vy *= decay;
+   
+   // Clamp speed to what the host resolved for this tick (profile, Shift)
+   double speed = std::hypot(s->vx, s->vy);
+   if (speed > tick->speed && speed > 0.0) {
+      double k = tick->speed / speed;
+      s->vx *= k;
+      s->vy *= k;
+   }
+   
+   // Integrate
+   tick->x += s->vx * tick->dt;
+   tick->y += s->vy * tick->dt;
+}
+
+static void inertiaReset(void *user) {
+   *static_cast<InertiaState *>(user) = InertiaState();
+}
+
+extern "C" MK_PLUGIN_EXPORT int mk_plugin_init(uint32_t host_abi_version, mk_plugin *out) {
+   if (host_abi_version < MK_PLUGIN_ABI_VERSION) return 1;
+   
+   out->abi_version = MK_PLUGIN_ABI_VERSION;
+   out->kind = MK_PLUGIN_MOTION;
+   out->name = "sample-inertia";
+   out->user = &g_state;
+   out->filter = nullptr;
+   out->motion = inertiaMotion;
+   out->shutdown = nullptr;
+   out->reset = inertiaReset;
+   return 0;
+}
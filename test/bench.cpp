@@ -0,0 +1,405 @@
+/*
+test/bench.cpp
+
+Micro-benchmarks for the engine's hot paths, built against the same Win32 shim
+as the fuzz harness so they run on Linux. Only `bench detect` is in ctest (it
+also checks its results); the rest are run by hand:
+   bench              every case
+   bench <case>...    only the named cases
+   bench detect <file.bmp>...
+                      vision detection on stored screenshots (24 or 32-bit
+                      BMP) instead of the generated 1080p and 4K frames
+bench_packed is built from this file with MOUSEKEYS_PACKED_LAYOUT, as the A/B
+baseline for the cache-line grouping of engine state. Each case prints one
+line per measurement. Compare runs on the same machine
+only; the numbers are for spotting regressions, not absolute claims.
+*/
+
+#include "../main.cpp"
+
+extern "C" int mk_plugin_init(uint32_t host_abi_version, mk_plugin *out); // plugins/sample_inertia.cpp
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+double nsPerOp(BenchClock::time_point start, uint64_t ops) {
+   std::chrono::duration<double, std::nano> elapsed = BenchClock::now() - start;
+   return ops ? elapsed.count() / ops : 0.0;
+}
+
+void report(const char *what, double value, const char *unit = "ns") {
+   std::printf("   %-44s %10.1f %s\n", what, value, unit);
+}
+
+// Screenshots named on the command line, for the detect case
+std::vector<const char *> g_screenshots;
+
+// Set by a case whose result is wrong, not just slow; main exits non-zero
+bool g_benchFailed = false;
+
+void sendKey(int vk, bool down) {
+   KBDLLHOOKSTRUCT kb = {};
+   kb.vkCode = (DWORD)vk;
+   handleKeyboardHook(HC_ACTION, down ? WM_KEYDOWN : WM_KEYUP, reinterpret_cast<LPARAM>(&kb));
+}
+
+// Engine enabled with nothing held, cursor mid-desktop
+void resetEngine(PhysicsState &st) {
+   clearHeldKeys();
+   g_keyEvents.drain(nullptr, KEY_EVENT_RING_SIZE);
+   g_control.enabled.store(true);
+   g_soak = SoakDesktop();
+   st = PhysicsState();
+   st.px = g_soak.cursor.x;
+   st.py = g_soak.cursor.y;
+}
+
+// Key presses on the hook thread while physics ticks on another, alone and
+// together. With the engine state grouped by writer the concurrent figures
+// should stay close to the solo ones.
+void benchHook() {
+   const int HOOK_CALLS = 2000000, TICKS = 500000;
+   const double dt = 1.0 / UPDATES_PER_SEC;
+   static const int KEYS[4] = { VK_RIGHT, VK_DOWN, VK_LEFT, VK_UP };
+   PhysicsState st;
+
+   resetEngine(st);
+   auto start = BenchClock::now();
+   for (int i = 0; i < HOOK_CALLS; ++i) {
+      sendKey(KEYS[(i >> 1) & 3], !(i & 1));
+      if ((i & 127) == 127) g_keyEvents.drain(nullptr, KEY_EVENT_RING_SIZE);
+   }
+   report("hook key event, physics idle", nsPerOp(start, HOOK_CALLS));
+
+   resetEngine(st);
+   sendKey(VK_RIGHT, true);
+   start = BenchClock::now();
+   for (int i = 0; i < TICKS; ++i) physicsTick(st, dt, SOAK_DESKTOP);
+   report("physics tick, hook idle", nsPerOp(start, TICKS));
+
+   resetEngine(st);
+   std::atomic<bool> stop(false);
+   std::atomic<uint64_t> ticks(0);
+   double tickNs = 0.0;
+   std::thread physics([&]() {
+      auto begin = BenchClock::now();
+      uint64_t n = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+         physicsTick(st, dt, SOAK_DESKTOP);
+         ++n;
+      }
+      tickNs = nsPerOp(begin, n);
+      ticks.store(n);
+   });
+   start = BenchClock::now();
+   for (int i = 0; i < HOOK_CALLS; ++i) sendKey(KEYS[(i >> 1) & 3], !(i & 1));
+   double hookNs = nsPerOp(start, HOOK_CALLS);
+   stop.store(true);
+   physics.join();
+   report("hook key event, physics ticking", hookNs);
+   report("physics tick, hook typing", tickNs);
+   std::printf("   (engine state %s; compare bench and bench_packed)\n",
+      CACHE_LINE == 64 ? "grouped by writer on 64-byte lines" : "packed, the pre-grouping baseline");
+   g_control.enabled.store(false);
+}
+
+// Stands in for plugins: installs at most one filter and one motion model
+void usePlugins(const mk_plugin *filter, const mk_plugin *motion) {
+   g_pluginCount = g_filterCount = 0;
+   g_motionPlugin = nullptr;
+   if (filter) {
+      g_plugins[g_pluginCount].desc = *filter;
+      g_filters[g_filterCount++] = &g_plugins[g_pluginCount++].desc;
+   }
+   if (motion) {
+      g_plugins[g_pluginCount].desc = *motion;
+      g_motionPlugin = &g_plugins[g_pluginCount++].desc;
+   }
+}
+
+void passFilter(void *, mk_tick *) {}
+
+// What a tick pays for the plugin ABI: one indirect call per plugin per tick,
+// on top of whatever the plugin itself does (the sample motion model here)
+void benchPlugin() {
+   const int TICKS = 100000, ROUNDS = 10;
+   const double dt = 1.0 / UPDATES_PER_SEC;
+   mk_plugin filter = {};
+   filter.abi_version = MK_PLUGIN_ABI_VERSION;
+   filter.kind = MK_PLUGIN_FILTER;
+   filter.filter = passFilter;
+   mk_plugin motion = {};
+   mk_plugin_init(MK_PLUGIN_ABI_VERSION, &motion);
+
+   struct Setup {
+      const char *what;
+      const mk_plugin *filter, *motion;
+   };
+   const Setup setups[] = {
+      { "tick, built-in integrator", nullptr, nullptr },
+      { "tick, pass-through filter", &filter, nullptr },
+      { "tick, sample_inertia motion model", nullptr, &motion },
+      { "tick, filter + motion model", &filter, &motion },
+   };
+   // Setups take turns and each keeps its best round, so warm-up and machine
+   // noise do not land on one setup only
+   const int SETUP_COUNT = sizeof(setups) / sizeof(setups[0]);
+   double best[SETUP_COUNT] = {};
+   PhysicsState st;
+   for (int round = 0; round < ROUNDS; ++round) {
+      for (int n = 0; n < SETUP_COUNT; ++n) {
+         usePlugins(setups[n].filter, setups[n].motion);
+         resetEngine(st);
+         sendKey(VK_RIGHT, true);
+         sendKey(VK_DOWN, true);
+         auto start = BenchClock::now();
+         for (int i = 0; i < TICKS; ++i) {
+            if ((i & 4095) == 0) { // back to the middle before the clamp takes over
+               g_soak.cursor = { 960, 540 };
+               st.px = 960.0;
+               st.py = 540.0;
+            }
+            physicsTick(st, dt, SOAK_DESKTOP);
+         }
+         double ns = nsPerOp(start, TICKS);
+         if (round == 0 || ns < best[n]) best[n] = ns;
+      }
+   }
+   for (int n = 0; n < SETUP_COUNT; ++n) report(setups[n].what, best[n]);
+   report("overhead per filter call", best[1] - best[0]);
+   usePlugins(nullptr, nullptr);
+   g_control.enabled.store(false);
+}
+
+// The position integrators on their own, driven back and forth by held keys
+// at a speed with no exact binary fraction per tick
+void benchIntegrator() {
+   const int TRIPS = 20000, LEG = 60;
+   const double dt = 1.0 / UPDATES_PER_SEC;
+   struct Integrator {
+      const char *what;
+      void (*step)(PhysicsState &, const mk_tick &, double);
+   };
+   const Integrator integrators[] = {
+      { "step, float", stepFloat },
+      { "step, fixed point", stepFixed },
+      { "step, MOMENTUM glide (keys held)", glide },
+   };
+   for (const Integrator &in : integrators) {
+      PhysicsState st;
+      st.px = st.py = 500.0;
+      mk_tick tick = {};
+      tick.speed = MAX_SPEED_PIX_PER_S * 0.37f;
+      auto start = BenchClock::now();
+      for (int trip = 0; trip < TRIPS; ++trip) {
+         for (int leg = 0; leg < 2; ++leg) {
+            tick.dir_x = leg ? -1.0f : 1.0f;
+            tick.dir_y = leg ? -std::sqrt(0.5f) : std::sqrt(0.5f);
+            for (int i = 0; i < LEG; ++i) in.step(st, tick, dt);
+         }
+      }
+      report(in.what, nsPerOp(start, (uint64_t)TRIPS * 2 * LEG));
+   }
+}
+
+// Speed curves: the lookup table the tick reads during ramp-up against running
+// the bytecode, for the browsers' curve in PROFILES
+void benchCurve() {
+   const int SAMPLES = 4000000;
+   SpeedCurve curve;
+   const char *text = "min(900, 200 + 900*t^1.5)";
+   if (const char *error = compileCurve(text, curve)) {
+      std::printf("   %s: %s\n", text, error);
+      return;
+   }
+   struct Path {
+      const char *what;
+      float (*sample)(const SpeedCurve &, float);
+   };
+   const Path paths[] = {
+      { "built-in formula (baseline)", [](const SpeedCurve &, float t) { return std::fmin(900.0f, 200.0f + 900.0f * t * std::sqrt(t)); } },
+      { "sampleCurve (table, t < 2 s)", sampleCurve },
+      { "evalCurve (bytecode)", evalCurve },
+   };
+   volatile float sink = 0.0f;
+   for (const Path &path : paths) {
+      float sum = 0.0f;
+      auto start = BenchClock::now();
+      for (int i = 0; i < SAMPLES; ++i) sum += path.sample(curve, (float)(i & 1023) * (CURVE_LUT_SPAN_S / 1024.0f));
+      report(path.what, nsPerOp(start, SAMPLES));
+      sink = sink + sum;
+   }
+}
+
+// A BGRA frame, top-down, as detectTargets takes it
+struct Frame {
+   std::string name;
+   int width = 0, height = 0;
+   std::vector<uint32_t> pixels;
+};
+
+// Reads an uncompressed 24 or 32-bit BMP (bottom-up or top-down)
+bool loadBmp(const char *path, Frame &frame) {
+   std::ifstream file(path, std::ios::binary);
+   std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+   auto u16 = [&](size_t at) { return (uint32_t)(bytes[at] | bytes[at + 1] << 8); };
+   auto u32 = [&](size_t at) { return u16(at) | u16(at + 2) << 16; };
+   if (bytes.size() < 54 || bytes[0] != 'B' || bytes[1] != 'M') return false;
+   uint32_t offset = u32(10), bpp = u16(28), compression = u32(30);
+   int width = (int32_t)u32(18), height = (int32_t)u32(22);
+   bool topDown = height < 0;
+   if (topDown) height = -height;
+   if (width <= 0 || height <= 0 || (bpp != 24 && bpp != 32) || (compression != 0 && compression != 3)) return false;
+   size_t stride = ((size_t)width * bpp / 8 + 3) & ~(size_t)3;
+   if (offset + stride * height > bytes.size()) return false;
+
+   frame.name = path;
+   frame.width = width;
+   frame.height = height;
+   frame.pixels.resize((size_t)width * height);
+   for (int y = 0; y < height; ++y) {
+      const uint8_t *row = bytes.data() + offset + stride * (topDown ? y : height - 1 - y);
+      for (int x = 0; x < width; ++x) {
+         const uint8_t *p = row + (size_t)x * (bpp / 8);
+         frame.pixels[(size_t)y * width + x] = 0xFF000000u | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0];
+      }
+   }
+   return true;
+}
+
+// A desktop stand-in: dialog panels full of bordered buttons with speckled
+// "text", on a faintly noisy background. The same seed always draws the same
+// frame, so the 4K one stands in for a checked-in capture. Button rects go to
+// `buttons` so detection can be checked against them.
+Frame syntheticFrame(int width, int height, std::vector<RECT> &buttons) {
+   Frame frame;
+   frame.name = "synthetic " + std::to_string(width) + "x" + std::to_string(height);
+   frame.width = width;
+   frame.height = height;
+   frame.pixels.assign((size_t)frame.width * frame.height, 0xFF3A6EA5u);
+   uint64_t rng = 0x9E3779B97F4A7C15ull;
+   for (uint32_t &p : frame.pixels) p += (uint32_t)(soakRandom(rng) % 3) * 0x010101u;
+
+   auto fill = [&](int left, int top, int right, int bottom, uint32_t color) {
+      for (int y = top; y < bottom; ++y) {
+         for (int x = left; x < right; ++x) frame.pixels[(size_t)y * frame.width + x] = color;
+      }
+   };
+   // Panel corners as fractions of the full-HD layout, so larger frames get
+   // proportionally larger panels holding more buttons of the same size
+   const RECT layout[] = { { 120, 90, 900, 700 }, { 1000, 300, 1800, 1000 } };
+   for (const RECT &at : layout) {
+      RECT panel = { at.left * width / 1920, at.top * height / 1080, at.right * width / 1920, at.bottom * height / 1080 };
+      fill(panel.left, panel.top, panel.right, panel.bottom, 0xFFF0F0F0u);
+      for (int y = panel.top + 40; y + 28 < panel.bottom; y += 48) {
+         for (int x = panel.left + 24; x + 96 < panel.right; x += 120) {
+            fill(x, y, x + 96, y + 28, 0xFF707070u);
+            fill(x + 1, y + 1, x + 95, y + 27, 0xFFE1E1E1u);
+            for (int i = 0; i < 40; ++i) {
+               int tx = x + 16 + (int)(soakRandom(rng) % 64), ty = y + 10 + (int)(soakRandom(rng) % 8);
+               frame.pixels[(size_t)ty * frame.width + tx] = 0xFF101010u;
+            }
+            buttons.push_back({ x, y, x + 96, y + 28 });
+         }
+      }
+   }
+   return frame;
+}
+
+// Vision fallback on whole frames: stored screenshots, or the full-HD and 4K
+// synthetic ones. On the synthetic frames every button must come back as a
+// target (edges within a couple of pixels), otherwise the case fails, so a
+// speed-up that breaks detection cannot pass as a win.
+void benchDetect() {
+   std::vector<Frame> frames;
+   std::vector<std::vector<RECT>> expected;
+   for (const char *path : g_screenshots) {
+      Frame frame;
+      if (loadBmp(path, frame)) {
+         frames.push_back(std::move(frame));
+         expected.emplace_back();
+      }
+      else std::printf("   %s: not a 24/32-bit uncompressed BMP, skipped\n", path);
+   }
+   if (g_screenshots.empty()) {
+      for (SIZE size : { SIZE{ 1920, 1080 }, SIZE{ 3840, 2160 } }) {
+         expected.emplace_back();
+         frames.push_back(syntheticFrame(size.cx, size.cy, expected.back()));
+      }
+   }
+
+   const int ROUNDS = 10;
+   std::vector<RECT> rects;
+   for (size_t f = 0; f < frames.size(); ++f) {
+      const Frame &frame = frames[f];
+      double best = 0.0;
+      for (int round = 0; round < ROUNDS; ++round) {
+         rects.clear();
+         auto start = BenchClock::now();
+         detectTargets(frame.pixels.data(), frame.width, frame.height, 0, 0, rects);
+         double ns = nsPerOp(start, 1);
+         if (round == 0 || ns < best) best = ns;
+      }
+      std::printf("   %s: %zu targets\n", frame.name.c_str(), rects.size());
+      report("detectTargets per frame", best / 1e6, "ms");
+      if (expected[f].empty()) continue;
+
+      const LONG SLACK = 2;
+      size_t found = 0;
+      for (const RECT &button : expected[f]) {
+         for (const RECT &r : rects) {
+            if (std::labs(r.left - button.left) <= SLACK && std::labs(r.top - button.top) <= SLACK &&
+                std::labs(r.right - button.right) <= SLACK && std::labs(r.bottom - button.bottom) <= SLACK) {
+               ++found;
+               break;
+            }
+         }
+      }
+      std::printf("   %s: %zu of %zu buttons found\n", frame.name.c_str(), found, expected[f].size());
+      if (found != expected[f].size()) g_benchFailed = true;
+   }
+}
+
+struct BenchCase {
+   const char *name;
+   void (*run)();
+};
+
+const BenchCase BENCH_CASES[] = {
+   { "hook", benchHook },
+   { "plugin", benchPlugin },
+   { "integrator", benchIntegrator },
+   { "detect", benchDetect },
+   { "curve", benchCurve },
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+   LARGE_INTEGER frequency;
+   QueryPerformanceFrequency(&frequency);
+   g_qpcFrequency = frequency.QuadPart;
+   compileProfileCurves();
+   buildDirectionTable();
+
+   std::vector<const char *> names;
+   for (int i = 1; i < argc; ++i) {
+      size_t len = std::strlen(argv[i]);
+      if (len > 4 && std::strcmp(argv[i] + len - 4, ".bmp") == 0) g_screenshots.push_back(argv[i]);
+      else names.push_back(argv[i]);
+   }
+   for (const BenchCase &c : BENCH_CASES) {
+      bool wanted = names.empty();
+      for (const char *name : names) wanted |= std::strcmp(name, c.name) == 0;
+      if (!wanted) continue;
+      std::printf("%s\n", c.name);
+      c.run();
+   }
+   return g_benchFailed ? 1 : 0;
+}
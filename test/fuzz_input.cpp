@@ -0,0 +1,159 @@
+/*
+test/fuzz_input.cpp
+
+Fuzz harness for the input path: decodes arbitrary bytes into key transitions
+and physics ticks, feeds them through the real hook body and physics tick
+against the soak simulator's virtual desktop, and aborts as soon as one of the
+engine's invariants breaks:
+- no mouse button is left down once control is off
+- the cursor stays on the desktop
+- the position never goes NaN/inf
+- the key event ring never holds more than it can
+
+Built with -DMOUSEKEYS_LIBFUZZER and -fsanitize=fuzzer it is a libFuzzer
+target. Otherwise it is a plain executable that replays the files named on the
+command line, or with no arguments runs a fixed number of pseudo-random inputs
+(what ctest runs).
+
+Input encoding, one byte per step:
+   bits 0-4  index into FUZZ_KEYS
+   bits 5-6  0 = key down (repeats included), 1 = key up (in any order, pressed
+             or not), 2 = 1..32 physics ticks, 3 = Caps Lock toggle tap
+   bit  7    send the transition as WM_SYSKEY* (as with Alt held)
+*/
+
+#include "../main.cpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+// Every key the hook treats specially, plus one it should ignore
+constexpr int FUZZ_KEYS[32] = {
+   VK_UP, VK_DOWN, VK_LEFT, VK_RIGHT, 'H', 'J', 'K', 'L',
+   LEFT_CLICK_KEY, RIGHT_CLICK_KEY, VK_LSHIFT, VK_RSHIFT, VK_CAPITAL, 'C', 'M', 'G',
+   'F', VK_ESCAPE, VK_NUMPAD7, VK_NUMPAD3, 'A', 'S', '0', '5',
+   '9', VK_LCONTROL, VK_RCONTROL, 'Q', 'W', 'E', 'R', 'T',
+};
+
+void check(bool ok, const char *what) {
+   if (ok) return;
+   std::fprintf(stderr, "invariant broken: %s\n", what);
+   std::abort();
+}
+
+void checkInvariants(const PhysicsState &st) {
+   uint32_t queued = g_keyEvents.head.load() - g_keyEvents.tail.load();
+   check(queued <= KEY_EVENT_RING_SIZE, "key event ring over capacity");
+   check(std::isfinite(st.px) && std::isfinite(st.py), "non-finite cursor position");
+   check(g_soak.cursor.x >= 0 && g_soak.cursor.y >= 0 && g_soak.cursor.x < g_soak.width
+      && g_soak.cursor.y < g_soak.height, "cursor off the desktop");
+   check(g_soak.strayUps == 0 && g_soak.doubleDowns == 0, "button events out of step");
+}
+
+// Back to a freshly started, disabled engine so inputs do not depend on each other
+void resetEngine(PhysicsState &st) {
+   g_control.enabled.store(false);
+   g_control.overlayOn.store(SHOW_OVERLAY);
+   g_control.lensOn.store(SHOW_LENS);
+   g_control.magnetOn.store(SNAP_TO_TARGETS);
+   cancelHints();
+   g_hookOwned.hintLastVk = 0;
+   clearHeldKeys();
+   g_keyEvents.drain(nullptr, KEY_EVENT_RING_SIZE);
+   g_physicsOwned.prevLeft.store(false);
+   g_physicsOwned.prevRight.store(false);
+   g_cursorRequests.warpPending.store(false);
+   g_cursorRequests.warpClick.store(false);
+   g_cursorRequests.physicalMoved.store(false);
+   g_soak = SoakDesktop();
+   st = PhysicsState();
+   st.px = g_soak.cursor.x;
+   st.py = g_soak.cursor.y;
+}
+
+void sendKey(int vk, bool down, bool sys, uint32_t timeMs) {
+   KBDLLHOOKSTRUCT kb = {};
+   kb.vkCode = (DWORD)vk;
+   kb.time = timeMs;
+   WPARAM msg = down ? (sys ? WM_SYSKEYDOWN : WM_KEYDOWN) : (sys ? WM_SYSKEYUP : WM_KEYUP);
+   handleKeyboardHook(HC_ACTION, msg, reinterpret_cast<LPARAM>(&kb));
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+   static bool initialised = false;
+   if (!initialised) {
+      LARGE_INTEGER frequency;
+      QueryPerformanceFrequency(&frequency);
+      g_qpcFrequency = frequency.QuadPart;
+      compileProfileCurves();
+      buildDirectionTable();
+      initialised = true;
+   }
+
+   static PhysicsState st;
+   resetEngine(st);
+   const double dt = 1.0 / UPDATES_PER_SEC;
+   uint64_t tick = 0;
+   auto step = [&]() {
+      physicsTick(st, dt, SOAK_DESKTOP);
+      ++tick;
+      checkInvariants(st);
+      if (!g_control.enabled.load()) {
+         check(!g_soak.buttons[0] && !g_soak.buttons[1], "button held after disable");
+      }
+   };
+
+   for (size_t i = 0; i < size; ++i) {
+      uint8_t b = data[i];
+      int vk = FUZZ_KEYS[b & 31];
+      bool sys = (b & 0x80) != 0;
+      uint32_t timeMs = (uint32_t)(tick * 1000 / UPDATES_PER_SEC);
+      switch ((b >> 5) & 3) {
+      case 0: sendKey(vk, true, sys, timeMs); break;
+      case 1: sendKey(vk, false, sys, timeMs); break;
+      case 2: for (int n = 0; n <= (b & 31); ++n) step(); break;
+      case 3:
+         sendKey(VK_CAPITAL, true, sys, timeMs);
+         sendKey(VK_CAPITAL, false, sys, timeMs);
+         break;
+      }
+      checkInvariants(st);
+   }
+
+   // Turning control off must let go of everything within a tick
+   if (g_control.enabled.load()) {
+      sendKey(VK_CAPITAL, true, false, 0);
+      sendKey(VK_CAPITAL, false, false, 0);
+   }
+   step();
+   return 0;
+}
+
+#ifndef MOUSEKEYS_LIBFUZZER
+int main(int argc, char **argv) {
+   if (argc > 1) {
+      for (int i = 1; i < argc; ++i) {
+         std::ifstream file(argv[i], std::ios::binary);
+         std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+         LLVMFuzzerTestOneInput(bytes.data(), bytes.size());
+      }
+      return 0;
+   }
+
+   // No corpus: a fixed stream of random inputs, so runs are reproducible
+   uint64_t rng = 0x2545F4914F6CDD1Dull;
+   std::vector<uint8_t> bytes;
+   for (int run = 0; run < 1000; ++run) {
+      bytes.resize(1 + soakRandom(rng) % 4096);
+      for (uint8_t &b : bytes) b = (uint8_t)soakRandom(rng);
+      LLVMFuzzerTestOneInput(bytes.data(), bytes.size());
+   }
+   std::printf("fuzz_input: 1000 random inputs, all invariants held\n");
+   return 0;
+}
+#endif
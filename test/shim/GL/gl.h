@@ -0,0 +1,86 @@
+// test/shim/GL/gl.h: the fixed-function OpenGL calls the overlay makes. They
+// draw nothing; clears, colours, quads and text are recorded in shimGl so tests
+// can check what a frame would have shown.
+#pragma once
+
+#include <string>
+#include <vector>
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef unsigned int GLbitfield;
+typedef int GLint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef float GLclampf;
+typedef double GLdouble;
+typedef void GLvoid;
+
+#define GL_LINES 0x0001
+#define GL_LINE_STRIP 0x0003
+#define GL_TRIANGLES 0x0004
+#define GL_QUADS 0x0007
+#define GL_LINE_SMOOTH 0x0B20
+#define GL_BLEND 0x0BE2
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_FLOAT 0x1406
+#define GL_MODELVIEW 0x1700
+#define GL_PROJECTION 0x1701
+#define GL_COLOR_BUFFER_BIT 0x4000
+#define GL_VERTEX_ARRAY 0x8074
+#define GL_COLOR_ARRAY 0x8076
+
+struct ShimGlFrame {
+   struct Color { float r, g, b; };
+   struct Quad { int left, top, right, bottom; Color color; }; // bounding box of 4 vertices
+   struct Text { int x, y; std::string text; Color color; };
+   float clear[4] = {};
+   bool cleared = false;
+   Color color = {};
+   std::vector<Quad> quads;
+   std::vector<Text> texts;
+   int rasterX = 0, rasterY = 0;
+   GLenum primitive = 0;
+   std::vector<GLint> vertices; // x, y pairs since glBegin(GL_QUADS)
+};
+inline ShimGlFrame shimGl;
+
+inline void glViewport(GLint, GLint, GLsizei, GLsizei) {}
+inline void glClearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a) { shimGl.clear[0] = r; shimGl.clear[1] = g; shimGl.clear[2] = b; shimGl.clear[3] = a; }
+inline void glClear(GLbitfield) { shimGl.cleared = true; shimGl.quads.clear(); shimGl.texts.clear(); }
+inline void glMatrixMode(GLenum) {}
+inline void glLoadIdentity() {}
+inline void glOrtho(GLdouble, GLdouble, GLdouble, GLdouble, GLdouble, GLdouble) {}
+inline void glBegin(GLenum mode) { shimGl.primitive = mode; shimGl.vertices.clear(); }
+inline void glEnd() {
+   for (size_t i = 0; shimGl.primitive == GL_QUADS && i + 8 <= shimGl.vertices.size(); i += 8) {
+      ShimGlFrame::Quad q = { shimGl.vertices[i], shimGl.vertices[i + 1], shimGl.vertices[i], shimGl.vertices[i + 1], shimGl.color };
+      for (size_t v = i; v < i + 8; v += 2) {
+         q.left = shimGl.vertices[v] < q.left ? shimGl.vertices[v] : q.left;
+         q.right = shimGl.vertices[v] > q.right ? shimGl.vertices[v] : q.right;
+         q.top = shimGl.vertices[v + 1] < q.top ? shimGl.vertices[v + 1] : q.top;
+         q.bottom = shimGl.vertices[v + 1] > q.bottom ? shimGl.vertices[v + 1] : q.bottom;
+      }
+      shimGl.quads.push_back(q);
+   }
+   shimGl.primitive = 0;
+}
+inline void glVertex2f(GLfloat, GLfloat) {}
+inline void glVertex2i(GLint x, GLint y) { shimGl.vertices.push_back(x); shimGl.vertices.push_back(y); }
+inline void glColor3f(GLfloat r, GLfloat g, GLfloat b) { shimGl.color = { r, g, b }; }
+inline void glLineWidth(GLfloat) {}
+inline void glRasterPos2i(GLint x, GLint y) { shimGl.rasterX = x; shimGl.rasterY = y; }
+inline void glListBase(GLuint) {}
+inline void glCallLists(GLsizei n, GLenum, const GLvoid *lists) {
+   shimGl.texts.push_back({ shimGl.rasterX, shimGl.rasterY, std::string(static_cast<const char *>(lists), (size_t)n), shimGl.color });
+}
+inline GLuint glGenLists(GLsizei) { return 0; }
+inline void glDeleteLists(GLuint, GLsizei) {}
+inline void glEnableClientState(GLenum) {}
+inline void glDisableClientState(GLenum) {}
+inline void glVertexPointer(GLint, GLenum, GLsizei, const GLvoid *) {}
+inline void glColorPointer(GLint, GLenum, GLsizei, const GLvoid *) {}
+inline void glDrawArrays(GLenum, GLint, GLsizei) {}
+inline void glFinish() {}
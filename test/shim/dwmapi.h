@@ -0,0 +1,4 @@
+// test/shim/dwmapi.h
+#pragma once
+
+inline HRESULT DwmFlush() { return S_OK; }
@@ -0,0 +1,6 @@
+// test/shim/psapi.h
+#pragma once
+
+struct PROCESS_MEMORY_COUNTERS_EX : PROCESS_MEMORY_COUNTERS {
+   SIZE_T PrivateUsage;
+};
@@ -0,0 +1,60 @@
+// test/shim/uiautomation.h: the UI Automation interfaces target collection
+// uses. CoCreateInstance always fails, so nothing here is ever called.
+#pragma once
+
+#define COINIT_MULTITHREADED 0x0
+#define CLSCTX_INPROC_SERVER 0x1
+#define VT_I4 3
+#define VT_BOOL 11
+#define VARIANT_TRUE ((short)-1)
+#define VARIANT_FALSE ((short)0)
+
+#define UIA_BoundingRectanglePropertyId 30001
+#define UIA_ControlTypePropertyId 30003
+#define UIA_IsOffscreenPropertyId 30022
+#define UIA_ButtonControlTypeId 50000
+#define UIA_CheckBoxControlTypeId 50002
+#define UIA_ComboBoxControlTypeId 50003
+#define UIA_EditControlTypeId 50004
+#define UIA_HyperlinkControlTypeId 50005
+#define UIA_ListItemControlTypeId 50007
+#define UIA_MenuItemControlTypeId 50011
+#define UIA_RadioButtonControlTypeId 50013
+#define UIA_TabItemControlTypeId 50019
+#define UIA_TreeItemControlTypeId 50024
+#define UIA_SplitButtonControlTypeId 50031
+
+struct GUID { unsigned long Data1; unsigned short Data2, Data3; unsigned char Data4[8]; };
+typedef GUID IID;
+typedef GUID CLSID;
+template <typename T> const GUID &shimUuidOf() { static const GUID id = {}; return id; }
+#define __uuidof(type) shimUuidOf<type>()
+
+struct VARIANT { unsigned short vt; union { long lVal; short boolVal; }; };
+enum TreeScope { TreeScope_Descendants = 0x4 };
+
+struct IUnknown { virtual unsigned long Release() = 0; };
+struct IUIAutomationCondition : IUnknown {};
+struct IUIAutomationCacheRequest : IUnknown { virtual HRESULT AddProperty(int id) = 0; };
+struct IUIAutomationElement;
+struct IUIAutomationElementArray : IUnknown {
+   virtual HRESULT get_Length(int *length) = 0;
+   virtual HRESULT GetElement(int index, IUIAutomationElement **element) = 0;
+};
+struct IUIAutomationElement : IUnknown {
+   virtual HRESULT FindAllBuildCache(TreeScope scope, IUIAutomationCondition *condition,
+      IUIAutomationCacheRequest *cache, IUIAutomationElementArray **found) = 0;
+   virtual HRESULT get_CachedBoundingRectangle(RECT *rect) = 0;
+};
+struct IUIAutomation : IUnknown {
+   virtual HRESULT ElementFromHandle(HWND hwnd, IUIAutomationElement **element) = 0;
+   virtual HRESULT CreatePropertyCondition(int id, VARIANT value, IUIAutomationCondition **condition) = 0;
+   virtual HRESULT CreateOrConditionFromNativeArray(IUIAutomationCondition **conditions, int count,
+      IUIAutomationCondition **condition) = 0;
+   virtual HRESULT CreateAndCondition(IUIAutomationCondition *a, IUIAutomationCondition *b,
+      IUIAutomationCondition **condition) = 0;
+   virtual HRESULT CreateCacheRequest(IUIAutomationCacheRequest **cache) = 0;
+};
+struct CUIAutomation {};
+
+inline HRESULT CoCreateInstance(const CLSID &, void *, DWORD, const IID &, void **out) { *out = nullptr; return -1; }
@@ -0,0 +1,458 @@
+/*
+test/shim/windows.h
+
+Just enough of the Win32 API for main.cpp to compile and link on Linux, so the
+fuzz harness and benchmarks can drive the hook body and physics tick
+in-process. Types and constants match the real headers where main.cpp relies
+on their values; every call is a no-op that reports failure or nothing, except
+for the handful the engine needs to behave (clock, screen size, cursor, hook
+chain).
+The shim screen is 1920x1080, matching the soak desktop. Tests can make
+every window belong to a process with the image path in shimProcessImage;
+UpdateLayeredWindow keeps its last call in shimLastLayered (see GL/gl.h too).
+Memory DCs hold real DIB sections, and the screen DC (GetDC) reads from the
+test image in shimScreen, so capture paths (lens, vision) run on known pixels.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <algorithm>
+#include <vector>
+
+#define WINAPI
+#define CALLBACK
+#define TRUE 1
+#define FALSE 0
+
+// --- Types ---
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+typedef long LONG;
+typedef unsigned int UINT;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef uintptr_t ULONG_PTR;
+typedef size_t SIZE_T;
+typedef long HRESULT;
+typedef intptr_t LPARAM;
+typedef uintptr_t WPARAM;
+typedef intptr_t LRESULT;
+typedef char *LPSTR;
+typedef const char *LPCSTR;
+typedef wchar_t WCHAR;
+typedef wchar_t *LPWSTR;
+typedef const wchar_t *LPCWSTR;
+typedef void *LPVOID;
+typedef DWORD COLORREF;
+
+typedef void *HANDLE;
+typedef void *HGDIOBJ;
+typedef struct HWND__ *HWND;
+typedef struct HINSTANCE__ *HINSTANCE;
+typedef HINSTANCE HMODULE;
+typedef struct HHOOK__ *HHOOK;
+typedef struct HMENU__ *HMENU;
+typedef struct HICON__ *HICON;
+typedef struct HCURSOR__ *HCURSOR;
+typedef struct HBRUSH__ *HBRUSH;
+typedef struct HDC__ *HDC;
+typedef struct HGLRC__ *HGLRC;
+typedef struct HBITMAP__ *HBITMAP;
+typedef struct HFONT__ *HFONT;
+typedef struct HMONITOR__ *HMONITOR;
+typedef struct HWINEVENTHOOK__ *HWINEVENTHOOK;
+
+typedef intptr_t (*FARPROC)();
+typedef LRESULT (*HOOKPROC)(int, WPARAM, LPARAM);
+typedef LRESULT (*WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef void (*WINEVENTPROC)(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD);
+
+struct POINT { LONG x, y; };
+typedef POINT *LPPOINT;
+struct SIZE { LONG cx, cy; };
+struct RECT { LONG left, top, right, bottom; };
+union LARGE_INTEGER { LONGLONG QuadPart; };
+struct MSG { HWND hwnd; UINT message; WPARAM wParam; LPARAM lParam; DWORD time; POINT pt; };
+struct KBDLLHOOKSTRUCT { DWORD vkCode, scanCode, flags, time; ULONG_PTR dwExtraInfo; };
+struct MSLLHOOKSTRUCT { POINT pt; DWORD mouseData, flags, time; ULONG_PTR dwExtraInfo; };
+struct MOUSEINPUT { LONG dx, dy; DWORD mouseData, dwFlags, time; ULONG_PTR dwExtraInfo; };
+struct KEYBDINPUT { WORD wVk, wScan; DWORD dwFlags, time; ULONG_PTR dwExtraInfo; };
+struct INPUT { DWORD type; union { MOUSEINPUT mi; KEYBDINPUT ki; }; };
+struct WNDCLASSEXW {
+   UINT cbSize, style;
+   WNDPROC lpfnWndProc;
+   int cbClsExtra, cbWndExtra;
+   HINSTANCE hInstance;
+   HICON hIcon;
+   HCURSOR hCursor;
+   HBRUSH hbrBackground;
+   LPCWSTR lpszMenuName, lpszClassName;
+   HICON hIconSm;
+};
+struct MONITORINFO { DWORD cbSize; RECT rcMonitor, rcWork; DWORD dwFlags; };
+struct SECURITY_ATTRIBUTES;
+struct OVERLAPPED { ULONG_PTR Internal, InternalHigh; DWORD Offset, OffsetHigh; HANDLE hEvent; };
+struct BLENDFUNCTION { BYTE BlendOp, BlendFlags, SourceConstantAlpha, AlphaFormat; };
+struct BITMAPINFOHEADER {
+   DWORD biSize;
+   LONG biWidth, biHeight;
+   WORD biPlanes, biBitCount;
+   DWORD biCompression, biSizeImage;
+   LONG biXPelsPerMeter, biYPelsPerMeter;
+   DWORD biClrUsed, biClrImportant;
+};
+struct RGBQUAD { BYTE rgbBlue, rgbGreen, rgbRed, rgbReserved; };
+struct BITMAPINFO { BITMAPINFOHEADER bmiHeader; RGBQUAD bmiColors[1]; };
+struct PIXELFORMATDESCRIPTOR {
+   WORD nSize, nVersion;
+   DWORD dwFlags;
+   BYTE iPixelType, cColorBits, cRedBits, cRedShift, cGreenBits, cGreenShift, cBlueBits, cBlueShift,
+      cAlphaBits, cAlphaShift, cAccumBits, cAccumRedBits, cAccumGreenBits, cAccumBlueBits, cAccumAlphaBits,
+      cDepthBits, cStencilBits, cAuxBuffers, iLayerType, bReserved;
+   DWORD dwLayerMask, dwVisibleMask, dwDamageMask;
+};
+struct FILETIME { DWORD dwLowDateTime, dwHighDateTime; };
+struct WIN32_FIND_DATAW {
+   DWORD dwFileAttributes;
+   FILETIME ftCreationTime, ftLastAccessTime, ftLastWriteTime;
+   DWORD nFileSizeHigh, nFileSizeLow, dwReserved0, dwReserved1;
+   WCHAR cFileName[260];
+   WCHAR cAlternateFileName[14];
+};
+struct PROCESS_MEMORY_COUNTERS {
+   DWORD cb, PageFaultCount;
+   SIZE_T PeakWorkingSetSize, WorkingSetSize, QuotaPeakPagedPoolUsage, QuotaPagedPoolUsage,
+      QuotaPeakNonPagedPoolUsage, QuotaNonPagedPoolUsage, PagefileUsage, PeakPagefileUsage;
+};
+
+// --- Constants ---
+#define WM_DESTROY 0x0002
+#define WM_PAINT 0x000F
+#define WM_CLOSE 0x0010
+#define WM_QUIT 0x0012
+#define WM_KEYDOWN 0x0100
+#define WM_KEYUP 0x0101
+#define WM_SYSKEYDOWN 0x0104
+#define WM_SYSKEYUP 0x0105
+#define WM_TIMER 0x0113
+#define WM_MOUSEMOVE 0x0200
+#define WM_HOTKEY 0x0312
+#define WM_APP 0x8000
+
+#define VK_SHIFT 0x10
+#define VK_CONTROL 0x11
+#define VK_CAPITAL 0x14
+#define VK_ESCAPE 0x1B
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+#define VK_NUMPAD0 0x60
+#define VK_NUMPAD1 0x61
+#define VK_NUMPAD2 0x62
+#define VK_NUMPAD3 0x63
+#define VK_NUMPAD4 0x64
+#define VK_NUMPAD6 0x66
+#define VK_NUMPAD7 0x67
+#define VK_NUMPAD8 0x68
+#define VK_NUMPAD9 0x69
+#define VK_LSHIFT 0xA0
+#define VK_RSHIFT 0xA1
+#define VK_LCONTROL 0xA2
+#define VK_RCONTROL 0xA3
+
+#define SM_CXSCREEN 0
+#define SM_CYSCREEN 1
+#define SM_XVIRTUALSCREEN 76
+#define SM_YVIRTUALSCREEN 77
+#define SM_CXVIRTUALSCREEN 78
+#define SM_CYVIRTUALSCREEN 79
+
+#define HC_ACTION 0
+#define WH_KEYBOARD_LL 13
+#define WH_MOUSE_LL 14
+#define LLKHF_INJECTED 0x10
+#define LLMHF_INJECTED 0x01
+#define INPUT_MOUSE 0
+#define INPUT_KEYBOARD 1
+#define KEYEVENTF_KEYUP 0x0002
+#define MOUSEEVENTF_LEFTDOWN 0x0002
+#define MOUSEEVENTF_LEFTUP 0x0004
+#define MOUSEEVENTF_RIGHTDOWN 0x0008
+#define MOUSEEVENTF_RIGHTUP 0x0010
+#define MOD_SHIFT 0x0004
+#define MOD_NOREPEAT 0x4000
+
+#define HWND_TOPMOST ((HWND)-1)
+#define HWND_MESSAGE ((HWND)-3)
+#define WS_POPUP 0x80000000
+#define WS_EX_TOPMOST 0x00000008
+#define WS_EX_TRANSPARENT 0x00000020
+#define WS_EX_TOOLWINDOW 0x00000080
+#define WS_EX_LAYERED 0x00080000
+#define WS_EX_NOACTIVATE 0x08000000
+#define SW_HIDE 0
+#define SW_SHOWNOACTIVATE 4
+#define ULW_ALPHA 0x00000002
+#define AC_SRC_OVER 0x00
+#define AC_SRC_ALPHA 0x01
+#define WDA_EXCLUDEFROMCAPTURE 0x00000011
+#define MB_ICONERROR 0x00000010
+#define MB_ICONWARNING 0x00000030
+#define PM_NOREMOVE 0x0000
+#define PM_REMOVE 0x0001
+#define MONITOR_DEFAULTTOPRIMARY 0x00000001
+#define MONITOR_DEFAULTTONEAREST 0x00000002
+#define EVENT_SYSTEM_FOREGROUND 0x0003
+#define WINEVENT_OUTOFCONTEXT 0x0000
+#define WINEVENT_SKIPOWNPROCESS 0x0002
+
+#define DIB_RGB_COLORS 0
+#define BI_RGB 0
+#define SRCCOPY 0x00CC0020
+#define CAPTUREBLT 0x40000000
+#define TRANSPARENT 1
+#define FW_BOLD 700
+#define DEFAULT_CHARSET 1
+#define OUT_DEFAULT_PRECIS 0
+#define CLIP_DEFAULT_PRECIS 0
+#define NONANTIALIASED_QUALITY 3
+#define ANTIALIASED_QUALITY 4
+#define DEFAULT_PITCH 0
+#define FIXED_PITCH 1
+#define FF_DONTCARE 0x00
+#define FF_MODERN 0x30
+#define PFD_DRAW_TO_BITMAP 0x00000008
+#define PFD_SUPPORT_GDI 0x00000010
+#define PFD_SUPPORT_OPENGL 0x00000020
+#define PFD_TYPE_RGBA 0
+#define PFD_MAIN_PLANE 0
+
+#define INFINITE 0xFFFFFFFF
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define MAX_PATH 260
+#define ERROR_ALREADY_EXISTS 183
+#define ERROR_MORE_DATA 234
+#define ERROR_PIPE_CONNECTED 535
+#define ERROR_IO_PENDING 997
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_SHARE_READ 0x00000001
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define FILE_FLAG_OVERLAPPED 0x40000000
+#define FILE_FLAG_FIRST_PIPE_INSTANCE 0x00080000
+#define MOVEFILE_REPLACE_EXISTING 0x00000001
+#define MOVEFILE_WRITE_THROUGH 0x00000008
+#define PIPE_ACCESS_DUPLEX 0x00000003
+#define PIPE_WAIT 0x00000000
+#define PIPE_READMODE_MESSAGE 0x00000002
+#define PIPE_TYPE_MESSAGE 0x00000004
+#define PIPE_REJECT_REMOTE_CLIENTS 0x00000008
+#define PROCESS_QUERY_LIMITED_INFORMATION 0x1000
+#define S_OK 0
+
+#define RGB(r, g, b) ((COLORREF)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+#define GetRValue(c) ((BYTE)(c))
+#define LOWORD(l) ((WORD)((uintptr_t)(l) & 0xffff))
+#define HIWORD(l) ((WORD)(((uintptr_t)(l) >> 16) & 0xffff))
+#define MAKEINTRESOURCEW(i) ((LPWSTR)(uintptr_t)(i))
+#define ZeroMemory(p, n) std::memset((p), 0, (n))
+#define SUCCEEDED(hr) ((HRESULT)(hr) >= 0)
+#define FAILED(hr) ((HRESULT)(hr) < 0)
+
+// --- Calls the engine depends on ---
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER *t) {
+   t->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+   return TRUE;
+}
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER *f) { f->QuadPart = 1000000000; return TRUE; }
+inline int GetSystemMetrics(int index) {
+   switch (index) {
+   case SM_CXSCREEN: case SM_CXVIRTUALSCREEN: return 1920;
+   case SM_CYSCREEN: case SM_CYVIRTUALSCREEN: return 1080;
+   default: return 0;
+   }
+}
+inline HMONITOR MonitorFromPoint(POINT, DWORD) { return nullptr; }
+inline BOOL GetMonitorInfoW(HMONITOR, MONITORINFO *mi) {
+   mi->rcMonitor = mi->rcWork = RECT{ 0, 0, 1920, 1080 };
+   return TRUE;
+}
+inline LRESULT CallNextHookEx(HHOOK, int, WPARAM, LPARAM) { return 0; }
+inline DWORD GetCurrentThreadId() { return 1; }
+inline POINT shimCursor = { 960, 540 };
+inline BOOL GetCursorPos(LPPOINT p) { *p = shimCursor; return TRUE; }
+inline BOOL SetCursorPos(int x, int y) { shimCursor = { x, y }; return TRUE; }
+
+// --- Everything else: no-ops ---
+inline UINT SendInput(UINT, INPUT *, int) { return 0; }
+inline short GetKeyState(int) { return 0; }
+inline HHOOK SetWindowsHookEx(int, HOOKPROC, HINSTANCE, DWORD) { return nullptr; }
+inline BOOL UnhookWindowsHookEx(HHOOK) { return TRUE; }
+inline BOOL RegisterHotKey(HWND, int, UINT, UINT) { return FALSE; }
+inline BOOL UnregisterHotKey(HWND, int) { return TRUE; }
+inline HWINEVENTHOOK SetWinEventHook(DWORD, DWORD, HMODULE, WINEVENTPROC, DWORD, DWORD, DWORD) { return nullptr; }
+inline BOOL UnhookWinEvent(HWINEVENTHOOK) { return TRUE; }
+
+inline LRESULT DefWindowProc(HWND, UINT, WPARAM, LPARAM) { return 0; }
+inline LRESULT DefWindowProcW(HWND, UINT, WPARAM, LPARAM) { return 0; }
+inline WORD RegisterClassExW(const WNDCLASSEXW *) { return 0; }
+inline HWND CreateWindowExW(DWORD, LPCWSTR, LPCWSTR, DWORD, int, int, int, int, HWND, HMENU, HINSTANCE, LPVOID) { return nullptr; }
+inline BOOL DestroyWindow(HWND) { return TRUE; }
+inline BOOL ShowWindow(HWND, int) { return TRUE; }
+inline BOOL GetWindowRect(HWND, RECT *r) { *r = RECT{ 0, 0, 0, 0 }; return FALSE; }
+inline BOOL SetWindowDisplayAffinity(HWND, DWORD) { return FALSE; }
+inline BOOL IsWindowVisible(HWND) { return FALSE; }
+inline BOOL IntersectRect(RECT *out, const RECT *a, const RECT *b) {
+   out->left = a->left > b->left ? a->left : b->left;
+   out->top = a->top > b->top ? a->top : b->top;
+   out->right = a->right < b->right ? a->right : b->right;
+   out->bottom = a->bottom < b->bottom ? a->bottom : b->bottom;
+   if (out->left < out->right && out->top < out->bottom) return TRUE;
+   *out = RECT{ 0, 0, 0, 0 };
+   return FALSE;
+}
+struct ShimLayeredUpdate { HWND hwnd; POINT dst; SIZE size; BYTE alpha; };
+inline ShimLayeredUpdate shimLastLayered = {}; // last UpdateLayeredWindow call
+inline BOOL UpdateLayeredWindow(HWND hwnd, HDC, POINT *dst, SIZE *size, HDC, POINT *, COLORREF, BLENDFUNCTION *blend, DWORD) {
+   shimLastLayered = { hwnd, dst ? *dst : POINT{}, size ? *size : SIZE{}, blend ? blend->SourceConstantAlpha : (BYTE)0 };
+   return FALSE;
+}
+inline HWND GetForegroundWindow() { return nullptr; }
+inline const wchar_t *shimProcessImage = nullptr; // owner of every window, nullptr = none
+inline DWORD GetWindowThreadProcessId(HWND, DWORD *pid) { if (pid) *pid = shimProcessImage ? 1 : 0; return shimProcessImage ? 1 : 0; }
+inline int MessageBoxW(HWND, LPCWSTR, LPCWSTR, UINT) { return 0; }
+
+inline BOOL GetMessage(MSG *, HWND, UINT, UINT) { return FALSE; }
+inline BOOL PeekMessageW(MSG *, HWND, UINT, UINT, UINT) { return FALSE; }
+inline BOOL WaitMessage() { return TRUE; }
+inline BOOL TranslateMessage(const MSG *) { return FALSE; }
+inline LRESULT DispatchMessage(const MSG *) { return 0; }
+inline LRESULT DispatchMessageW(const MSG *) { return 0; }
+inline BOOL PostThreadMessageW(DWORD, UINT, WPARAM, LPARAM) { return FALSE; }
+
+inline HANDLE GetCurrentProcess() { return (HANDLE)(intptr_t)-1; }
+inline HANDLE OpenProcess(DWORD, BOOL, DWORD pid) { return (pid == 1 && shimProcessImage) ? (HANDLE)&shimProcessImage : nullptr; }
+inline BOOL QueryFullProcessImageNameW(HANDLE process, DWORD, LPWSTR path, DWORD *len) {
+   if (process != (HANDLE)&shimProcessImage || !shimProcessImage || std::wcslen(shimProcessImage) >= *len) return FALSE;
+   std::wcscpy(path, shimProcessImage);
+   *len = (DWORD)std::wcslen(path);
+   return TRUE;
+}
+inline DWORD GetModuleFileNameW(HMODULE, LPWSTR path, DWORD size) { if (size) path[0] = 0; return 0; }
+inline DWORD GetLastError() { return 0; }
+inline HMODULE LoadLibraryW(LPCWSTR) { return nullptr; }
+inline FARPROC GetProcAddress(HMODULE, LPCSTR) { return nullptr; }
+inline BOOL FreeLibrary(HMODULE) { return TRUE; }
+inline BOOL GetProcessMemoryInfo(HANDLE, PROCESS_MEMORY_COUNTERS *, DWORD) { return FALSE; }
+inline int lstrcmpiW(LPCWSTR a, LPCWSTR b) {
+   while (*a && std::towlower(*a) == std::towlower(*b)) ++a, ++b;
+   return (int)std::towlower(*a) - (int)std::towlower(*b);
+}
+
+inline HANDLE CreateFileW(LPCWSTR, DWORD, DWORD, SECURITY_ATTRIBUTES *, DWORD, DWORD, HANDLE) { return INVALID_HANDLE_VALUE; }
+inline BOOL ReadFile(HANDLE, LPVOID, DWORD, DWORD *read, OVERLAPPED *) { if (read) *read = 0; return FALSE; }
+inline BOOL WriteFile(HANDLE, const void *, DWORD, DWORD *written, OVERLAPPED *) { if (written) *written = 0; return FALSE; }
+inline BOOL CloseHandle(HANDLE) { return TRUE; }
+inline BOOL MoveFileExW(LPCWSTR, LPCWSTR, DWORD) { return FALSE; }
+inline HANDLE FindFirstFileW(LPCWSTR, WIN32_FIND_DATAW *) { return INVALID_HANDLE_VALUE; }
+inline BOOL FindNextFileW(HANDLE, WIN32_FIND_DATAW *) { return FALSE; }
+inline BOOL FindClose(HANDLE) { return TRUE; }
+inline HANDLE CreateNamedPipeW(LPCWSTR, DWORD, DWORD, DWORD, DWORD, DWORD, DWORD, SECURITY_ATTRIBUTES *) { return INVALID_HANDLE_VALUE; }
+inline BOOL ConnectNamedPipe(HANDLE, OVERLAPPED *) { return FALSE; }
+inline BOOL DisconnectNamedPipe(HANDLE) { return FALSE; }
+inline BOOL CancelIoEx(HANDLE, OVERLAPPED *) { return FALSE; }
+inline BOOL GetOverlappedResult(HANDLE, OVERLAPPED *, DWORD *, BOOL) { return FALSE; }
+
+inline HANDLE CreateEventW(SECURITY_ATTRIBUTES *, BOOL, BOOL, LPCWSTR) { return nullptr; }
+inline BOOL SetEvent(HANDLE) { return TRUE; }
+inline BOOL ResetEvent(HANDLE) { return TRUE; }
+inline DWORD WaitForSingleObject(HANDLE, DWORD) { return WAIT_OBJECT_0; }
+inline DWORD WaitForMultipleObjects(DWORD, const HANDLE *, BOOL, DWORD) { return WAIT_OBJECT_0; }
+
+struct ShimBitmap { int width, height; bool topDown; std::vector<uint32_t> pixels; };
+struct ShimDc { ShimBitmap *bitmap = nullptr; };
+struct ShimScreen { int width = 0, height = 0; std::vector<uint32_t> pixels; }; // top-down BGRA at (0, 0); empty = black
+inline ShimScreen shimScreen;
+inline ShimDc shimScreenDc;
+inline std::vector<ShimBitmap *> shimBitmaps; // live DIB sections, to tell them from other GDI objects
+
+inline HDC GetDC(HWND) { return reinterpret_cast<HDC>(&shimScreenDc); }
+inline int ReleaseDC(HWND, HDC) { return 1; }
+inline HDC CreateCompatibleDC(HDC) { return reinterpret_cast<HDC>(new ShimDc()); }
+inline BOOL DeleteDC(HDC dc) {
+   if (dc && reinterpret_cast<ShimDc *>(dc) != &shimScreenDc) delete reinterpret_cast<ShimDc *>(dc);
+   return TRUE;
+}
+inline HBITMAP CreateDIBSection(HDC, const BITMAPINFO *bmi, UINT, void **bits, HANDLE, DWORD) {
+   int width = bmi->bmiHeader.biWidth, height = bmi->bmiHeader.biHeight;
+   ShimBitmap *b = new ShimBitmap{ width, height < 0 ? -height : height, height < 0, {} };
+   b->pixels.assign((size_t)b->width * b->height, 0);
+   shimBitmaps.push_back(b);
+   if (bits) *bits = b->pixels.data();
+   return reinterpret_cast<HBITMAP>(b);
+}
+inline HGDIOBJ SelectObject(HDC dc, HGDIOBJ object) {
+   ShimBitmap *b = static_cast<ShimBitmap *>(object);
+   if (!dc || std::find(shimBitmaps.begin(), shimBitmaps.end(), b) == shimBitmaps.end()) return nullptr;
+   ShimDc *d = reinterpret_cast<ShimDc *>(dc);
+   ShimBitmap *old = d->bitmap;
+   d->bitmap = b;
+   return old;
+}
+inline BOOL DeleteObject(HGDIOBJ object) {
+   auto it = std::find(shimBitmaps.begin(), shimBitmaps.end(), static_cast<ShimBitmap *>(object));
+   if (it != shimBitmaps.end()) {
+      delete *it;
+      shimBitmaps.erase(it);
+   }
+   return TRUE;
+}
+// Screen to memory DC only; screen pixels outside the test image read as black
+inline BOOL BitBlt(HDC dst, int x, int y, int width, int height, HDC src, int srcX, int srcY, DWORD) {
+   ShimBitmap *b = dst ? reinterpret_cast<ShimDc *>(dst)->bitmap : nullptr;
+   if (!b || reinterpret_cast<ShimDc *>(src) != &shimScreenDc) return FALSE;
+   for (int row = 0; row < height; ++row) {
+      int by = y + row, sy = srcY + row;
+      if (by < 0 || by >= b->height) continue;
+      uint32_t *line = b->pixels.data() + (size_t)(b->topDown ? by : b->height - 1 - by) * b->width;
+      for (int col = 0; col < width; ++col) {
+         int bx = x + col, sx = srcX + col;
+         if (bx < 0 || bx >= b->width) continue;
+         bool inside = sx >= 0 && sy >= 0 && sx < shimScreen.width && sy < shimScreen.height;
+         line[bx] = inside ? shimScreen.pixels[(size_t)sy * shimScreen.width + sx] : 0;
+      }
+   }
+   return TRUE;
+}
+inline BOOL GdiFlush() { return TRUE; }
+inline HFONT CreateFontW(int, int, int, int, int, DWORD, DWORD, DWORD, DWORD, DWORD, DWORD, DWORD, DWORD, LPCWSTR) { return nullptr; }
+inline HBRUSH CreateSolidBrush(COLORREF) { return nullptr; }
+inline int FillRect(HDC, const RECT *, HBRUSH) { return 0; }
+inline int SetBkMode(HDC, int) { return 0; }
+inline COLORREF SetTextColor(HDC, COLORREF) { return 0; }
+inline BOOL TextOutW(HDC, int, int, LPCWSTR, int) { return FALSE; }
+inline BOOL GetTextExtentPoint32W(HDC, LPCWSTR, int, SIZE *size) { size->cx = size->cy = 0; return FALSE; }
+inline int ChoosePixelFormat(HDC, const PIXELFORMATDESCRIPTOR *) { return 0; }
+inline BOOL SetPixelFormat(HDC, int, const PIXELFORMATDESCRIPTOR *) { return FALSE; }
+inline HGLRC wglCreateContext(HDC) { return nullptr; }
+inline BOOL wglMakeCurrent(HDC, HGLRC) { return FALSE; }
+inline BOOL wglDeleteContext(HGLRC) { return TRUE; }
+inline BOOL wglUseFontBitmapsW(HDC, DWORD, DWORD, DWORD) { return FALSE; }
+
+inline HRESULT CoInitializeEx(void *, DWORD) { return -1; }
+inline void CoUninitialize() {}
+inline BOOL SetProcessDPIAware() { return TRUE; }
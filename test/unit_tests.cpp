@@ -0,0 +1,868 @@
+/*
+test/unit_tests.cpp
+
+Deterministic checks of the engine's pure pieces, built against the same Win32
+shim as the fuzz harness. Each case pins down one behaviour with fixed inputs;
+ctest runs them all:
+   unit_tests           every case
+   unit_tests <case>... only the named cases
+A failed check prints its file, line and expression; the run exits non-zero
+if any did.
+*/
+
+#include "../main.cpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#ifndef MOUSEKEYS_FIXTURE_DIR
+#define MOUSEKEYS_FIXTURE_DIR "test/fixtures"
+#endif
+
+namespace {
+
+int g_failures = 0;
+
+void fail(const char *file, int line, const char *what) {
+   std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+   ++g_failures;
+}
+
+#define CHECK(expr) ((expr) ? (void)0 : fail(__FILE__, __LINE__, #expr))
+#define CHECK_NEAR(a, b, tolerance) (std::fabs((double)(a) - (double)(b)) <= (tolerance) ? (void)0 : fail(__FILE__, __LINE__, #a " ~= " #b))
+
+// Value of a curve expression at t, or NaN if it does not compile
+float curveAt(const char *text, float t) {
+   SpeedCurve curve;
+   if (compileCurve(text, curve)) return std::nanf("");
+   return sampleCurve(curve, t);
+}
+
+// --- Speed curves ---
+
+void testCurvePrecedence() {
+   CHECK(curveAt("2+3*4", 0.0f) == 14.0f);
+   CHECK(curveAt("(2+3)*4", 0.0f) == 20.0f);
+   CHECK(curveAt("2^3^2", 0.0f) == 512.0f); // right-associative
+   CHECK(curveAt("10-4-3", 0.0f) == 3.0f);  // left-associative
+   CHECK(curveAt("8/2/2", 0.0f) == 2.0f);
+   CHECK(curveAt("-2^2+10", 0.0f) == 6.0f); // unary minus binds looser than ^
+   CHECK(curveAt("clamp(5, 1, 3) + min(1, 2) + max(1, 2)", 0.0f) == 6.0f);
+   CHECK(curveAt("sqrt(16) + abs(-1) + exp(0)", 0.0f) == 6.0f);
+   CHECK_NEAR(curveAt("200 + 900*t^1.5", 1.0f), 1100.0f, 1e-3);
+   CHECK_NEAR(curveAt("100*t", 1.0f), 100.0f, 1e-3); // interpolated from the table
+   CHECK_NEAR(curveAt("100*t", 3.0f), 300.0f, 1e-3); // past the table
+}
+
+void testCurveErrors() {
+   SpeedCurve curve;
+   const char *bad[] = {
+      "", "2+", "(2", "min(1)", "foo(1)", "t t", "2 $ 3", "1e99", "inf", "0x10",
+      "1/t",           // infinite at t = 0
+      "sqrt(t - 1)",   // NaN before t = 1
+      "100 - 900*t",   // negative after ~0.1 s
+      "-t",
+   };
+   for (const char *text : bad) {
+      if (!compileCurve(text, curve)) fail(__FILE__, __LINE__, text);
+      CHECK(!curve.valid);
+   }
+   CHECK(std::strcmp(compileCurve("100 - 900*t", curve), "curve goes negative during ramp-up") == 0);
+   CHECK(compileCurve("min(900, 200 + 900*t^1.5)", curve) == nullptr && curve.valid);
+}
+
+void testCurveClamp() {
+   CHECK(curveAt("1e9", 0.5f) == CURVE_MAX_SPEED);
+   CHECK(curveAt("1e9", 5.0f) == CURVE_MAX_SPEED);
+   CHECK(curveAt("100 + 1000*t^4", 10.0f) == CURVE_MAX_SPEED); // past the table
+   CHECK(curveAt("max(0, 100 - 40*t)", 5.0f) == 0.0f);
+   CHECK(curveAt("abs(100 - 40*t)", 5.0f) == 100.0f);
+   CHECK(curveAt("1/(t - 3)^2", 3.0f) == CURVE_MAX_SPEED); // infinite past the table
+   CHECK(curveAt("sqrt(2 - t) + 1", 4.0f) == 0.0f);        // NaN past the table stops
+}
+
+// --- SOCD ---
+
+uint8_t slotBit(Action action) {
+   return (uint8_t)(1u << directionSlotOf((uint32_t)action));
+}
+
+mk_key_event keyEvent(Action action, bool down) {
+   return mk_key_event{ 0, (uint32_t)action, down ? 1u : 0u, 0 };
+}
+
+// Hold one direction, then press its opposite on a later tick; returns what
+// the policy makes of the overlap
+uint8_t overlap(Socd policy, Action first, Action second) {
+   PhysicsState st;
+   mk_key_event press = keyEvent(first, true);
+   uint8_t held = slotBit(first);
+   resolveSocd(st, policy, held, &press, 1);
+   press = keyEvent(second, true);
+   held |= slotBit(second);
+   return resolveSocd(st, policy, held, &press, 1);
+}
+
+void testSocdPolicies() {
+   uint8_t left = slotBit(Action::Left), right = slotBit(Action::Right);
+   uint8_t up = slotBit(Action::Up), down = slotBit(Action::Down);
+   
+   // Neutral leaves the pair for the direction table to cancel
+   CHECK(overlap(Socd::Neutral, Action::Left, Action::Right) == (left | right));
+   CHECK(g_directionTable[left | right].x == 0.0f && g_directionTable[left | right].y == 0.0f);
+   
+   CHECK(overlap(Socd::LastWins, Action::Left, Action::Right) == right);
+   CHECK(overlap(Socd::LastWins, Action::Right, Action::Left) == left);
+   CHECK(overlap(Socd::FirstWins, Action::Left, Action::Right) == left);
+   CHECK(overlap(Socd::FirstWins, Action::Right, Action::Left) == right);
+   
+   // Up is the priority slot; Left/Right has none, so it cancels
+   CHECK(overlap(Socd::Priority, Action::Up, Action::Down) == up);
+   CHECK(overlap(Socd::Priority, Action::Down, Action::Up) == up);
+   CHECK(overlap(Socd::Priority, Action::Left, Action::Right) == (left | right));
+   
+   // Both pressed in one tick: the ring's order decides
+   PhysicsState st;
+   mk_key_event both[2] = { keyEvent(Action::Right, true), keyEvent(Action::Left, true) };
+   CHECK(resolveSocd(st, Socd::LastWins, left | right, both, 2) == left);
+   
+   // Releasing the winner hands the axis back to the key still held
+   st = PhysicsState();
+   CHECK(resolveSocd(st, Socd::LastWins, left | right, both, 2) == left);
+   mk_key_event release = keyEvent(Action::Left, false);
+   CHECK(resolveSocd(st, Socd::LastWins, right, &release, 1) == right);
+   
+   // A held slot with no press in the ring (overflow) counts as the newest
+   st = PhysicsState();
+   mk_key_event press = keyEvent(Action::Up, true);
+   resolveSocd(st, Socd::LastWins, up, &press, 1);
+   CHECK(resolveSocd(st, Socd::LastWins, up | down, nullptr, 0) == down);
+}
+
+// --- Glide and flicks ---
+
+// Coast with no keys held until the glide stops; returns the distance covered
+double coast(PhysicsState &st, double dt, int &ticks) {
+   double x0 = st.px, y0 = st.py;
+   mk_tick idle = {};
+   for (ticks = 0; (st.vx != 0.0 || st.vy != 0.0) && ticks < 100000; ++ticks) glide(st, idle, dt);
+   return std::hypot(st.px - x0, st.py - y0);
+}
+
+void testGlideFlick() {
+   // Right tapped twice inside the window launches a flick to the right
+   PhysicsState st;
+   mk_key_event taps[3] = { keyEvent(Action::Right, true), keyEvent(Action::Right, false), keyEvent(Action::Right, true) };
+   taps[2].time_ms = FLICK_WINDOW_MS - 1;
+   detectFlicks(st, taps, 3);
+   CHECK(st.vx == FLICK_SPEED_PIX_PER_S && st.vy == 0.0);
+   
+   // It covers v0 / k whatever the tick rate (less what is left below the stop speed), then stops
+   const double reach = FLICK_SPEED_PIX_PER_S / GLIDE_FRICTION_PER_S;
+   const double tail = GLIDE_STOP_PIX_PER_S / GLIDE_FRICTION_PER_S;
+   for (double dt : { 1.0 / UPDATES_PER_SEC, 1.0 / 60.0, 1.0 / 1000.0 }) {
+      PhysicsState glider;
+      glider.vx = FLICK_SPEED_PIX_PER_S;
+      int ticks = 0;
+      double covered = coast(glider, dt, ticks);
+      CHECK(covered <= reach && covered >= reach - tail);
+      CHECK(glider.vx == 0.0 && glider.vy == 0.0);
+      CHECK(ticks < 100000);
+      double stoppedAt = glider.px;
+      mk_tick idle = {};
+      glide(glider, idle, dt);
+      CHECK(glider.px == stoppedAt); // stopped means stopped
+   }
+   
+   // Taps too far apart, or a third tap, do not launch (another)
+   st = PhysicsState();
+   taps[2].time_ms = FLICK_WINDOW_MS + 1;
+   detectFlicks(st, taps, 3);
+   CHECK(st.vx == 0.0);
+   st = PhysicsState();
+   mk_key_event four[5] = { taps[0], taps[1], taps[0], taps[1], taps[0] };
+   detectFlicks(st, four, 3);
+   st.vx = 0.0;
+   detectFlicks(st, four + 3, 2);
+   CHECK(st.vx == 0.0);
+   
+   // Held keys take over from a slower glide
+   st = PhysicsState();
+   st.vx = 100.0;
+   mk_tick held = {};
+   held.dir_x = 1.0f;
+   held.speed = 500.0f;
+   glide(st, held, 0.01);
+   CHECK(st.vx == 500.0);
+   CHECK_NEAR(st.px, 5.0, 1e-9);
+}
+
+// Parking keeps the sub-pixel position unless the OS cursor really moved
+void testResyncFromCursor() {
+   PhysicsState st;
+   st.px = 100.4;
+   st.py = 50.6;
+   resyncFromCursor(st, POINT{ 100, 51 });
+   CHECK(st.px == 100.4 && st.py == 50.6);
+   resyncFromCursor(st, POINT{ 101, 51 });
+   CHECK(st.px == 101.0 && st.py == 51.0);
+}
+
+// --- Count nudges and jumps (through the real hook and tick) ---
+
+void sendKey(int vk, bool down) {
+   KBDLLHOOKSTRUCT kb = {};
+   kb.vkCode = (DWORD)vk;
+   handleKeyboardHook(HC_ACTION, down ? WM_KEYDOWN : WM_KEYUP, reinterpret_cast<LPARAM>(&kb));
+}
+
+void tapKey(int vk) {
+   sendKey(vk, true);
+   sendKey(vk, false);
+}
+
+// Enabled, nothing held, soak cursor at (x, y) and published to the snapshot
+void resetEngine(PhysicsState &st, int x, int y) {
+   clearHeldKeys();
+   g_keyEvents.drain(nullptr, KEY_EVENT_RING_SIZE);
+   g_cursorRequests.warpPending.store(false);
+   g_cursorRequests.physicalMoved.store(false);
+   g_control.enabled.store(true);
+   g_control.magnetOn.store(false);
+   g_soak = SoakDesktop();
+   g_soak.cursor = { x, y };
+   st = PhysicsState();
+   st.px = x;
+   st.py = y;
+   physicsTick(st, 1.0 / UPDATES_PER_SEC, SOAK_DESKTOP);
+}
+
+void testCountNudge() {
+   PhysicsState st;
+   const double dt = 1.0 / UPDATES_PER_SEC;
+   
+   // "10l" moves exactly 10 px right, and holding on does not move it further
+   resetEngine(st, 500, 400);
+   tapKey('1');
+   tapKey('0');
+   sendKey('L', true);
+   sendKey('L', true); // auto-repeat is swallowed with the press
+   physicsTick(st, dt, SOAK_DESKTOP);
+   physicsTick(st, dt, SOAK_DESKTOP);
+   sendKey('L', false);
+   CHECK(g_soak.cursor.x == 510 && g_soak.cursor.y == 400);
+   CHECK(g_hookOwned.nudgeCount == 0 && g_hookOwned.directionMask.load() == 0);
+   
+   // Diagonals move the count on both axes
+   tapKey('7');
+   tapKey(VK_NUMPAD3); // DownRight
+   physicsTick(st, dt, SOAK_DESKTOP);
+   CHECK(g_soak.cursor.x == 517 && g_soak.cursor.y == 407);
+   
+   // A count followed by an unbound key is dropped; the next direction key moves normally
+   resetEngine(st, 500, 400);
+   tapKey('5');
+   tapKey('Q');
+   CHECK(g_hookOwned.nudgeCount == 0);
+   sendKey('L', true);
+   CHECK(!g_cursorRequests.warpPending.load() && g_hookOwned.directionMask.load() != 0);
+   sendKey('L', false);
+   
+   // So does Escape
+   tapKey('5');
+   tapKey(VK_ESCAPE);
+   CHECK(g_hookOwned.nudgeCount == 0);
+   
+   // Ctrl jumps half the monitor, and clamps to its edge
+   resetEngine(st, 1500, 400);
+   sendKey(VK_LCONTROL, true);
+   tapKey('H'); // Left
+   physicsTick(st, dt, SOAK_DESKTOP);
+   CHECK(g_soak.cursor.x == 540 && g_soak.cursor.y == 400);
+   tapKey('L');
+   tapKey('L'); // second jump lands on the pending warp, then clamps
+   physicsTick(st, dt, SOAK_DESKTOP);
+   CHECK(g_soak.cursor.x == 1919 && g_soak.cursor.y == 400);
+   sendKey(VK_LCONTROL, false);
+   
+   // Counts stop at NUDGE_MAX_COUNT and clamp at the edge as well
+   resetEngine(st, 10, 10);
+   for (int i = 0; i < 6; ++i) tapKey('9');
+   CHECK(g_hookOwned.nudgeCount == NUDGE_MAX_COUNT);
+   tapKey('K'); // Up
+   physicsTick(st, dt, SOAK_DESKTOP);
+   CHECK(g_soak.cursor.x == 10 && g_soak.cursor.y == 0);
+   g_control.enabled.store(false);
+}
+
+// --- Fixed point ---
+
+constexpr fixed32 FIXED_ONE_BITS = (fixed32)1 << 32;
+
+void testMulFixed() {
+   const fixed32 edges[] = {
+      0, 1, -1, FIXED_ONE_BITS, -FIXED_ONE_BITS, FIXED_ONE_BITS / 2, -FIXED_ONE_BITS / 3,
+      (fixed32)0x7FFFFFFFFFFFFFFFll, (fixed32)(-0x7FFFFFFFFFFFFFFFll - 1), (fixed32)0x00000000FFFFFFFFll,
+      toFixed(1919.999), toFixed(-0.70710677), toFixed(6000.0), toFixed(1.0 / 240.0),
+   };
+   for (fixed32 a : edges) {
+      for (fixed32 b : edges) {
+         fixed32 p = mulFixedPortable(a, b);
+         CHECK(p == mulFixedPortable(b, a));
+#if defined(__SIZEOF_INT128__)
+         CHECK(p == (fixed32)(((__int128)a * b) >> 32));
+#endif
+         CHECK(p == mulFixed(a, b));
+      }
+   }
+   uint64_t rng = 0x9E3779B97F4A7C15ull;
+   for (int i = 0; i < 100000; ++i) {
+      fixed32 a = (fixed32)soakRandom(rng), b = (fixed32)soakRandom(rng);
+      if (i & 1) b >>= 24; // screen-sized operands as well as full-range ones
+      CHECK(mulFixedPortable(a, b) == mulFixed(a, b));
+   }
+   CHECK(mulFixed(toFixed(1.5), toFixed(-2.0)) == toFixed(-3.0));
+   CHECK(mulFixed(-1, 1) == -1); // rounds toward -inf
+}
+
+// A fixed-point run must land on the same bits on every compiler and FP mode;
+// these were recorded once and must never drift
+void testFixedTrajectory() {
+   PhysicsState st;
+   st.px = 100.25;
+   st.py = 700.75;
+   mk_tick tick = {};
+   tick.speed = 1234.5f;
+   tick.dir_x = 0.70710677f;
+   tick.dir_y = -0.70710677f;
+   for (int i = 0; i < 1000; ++i) {
+      if (i == 500) {
+         tick.speed = 37.25f;
+         tick.dir_x = -1.0f;
+         tick.dir_y = 0.0f;
+      }
+      stepFixed(st, tick, 1.0 / 240.0);
+   }
+   CHECK(st.fixedX == 7908048612424ll);
+   CHECK(st.fixedY == -4801087165328ll);
+   CHECK(st.px == fromFixed(st.fixedX) && st.py == fromFixed(st.fixedY));
+}
+
+// --- Direction tables ---
+
+void testDirectionTable() {
+   // Every mask matches the normalised sum of its slots' unit vectors (y down)
+   for (int mask = 0; mask < (1 << DIRECTION_SLOT_COUNT); ++mask) {
+      double x = 0.0, y = 0.0;
+      for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+         if (!(mask & (1 << s))) continue;
+         x += std::cos(DIRECTION_SLOTS[s].degrees * 3.14159265358979323846 / 180.0);
+         y -= std::sin(DIRECTION_SLOTS[s].degrees * 3.14159265358979323846 / 180.0);
+      }
+      double len = std::hypot(x, y);
+      const DirectionVector &dir = g_directionTable[mask];
+      if (len < 1e-6) {
+         CHECK(dir.x == 0.0f && dir.y == 0.0f);
+         continue;
+      }
+      CHECK_NEAR(dir.x, x / len, 1e-6);
+      CHECK_NEAR(dir.y, y / len, 1e-6);
+   }
+   
+   // Single keys come out exact, from sqrt alone
+   const float h = (float)std::sqrt(0.5);
+   CHECK(g_directionTable[slotBit(Action::Right)].x == 1.0f && g_directionTable[slotBit(Action::Right)].y == 0.0f);
+   CHECK(g_directionTable[slotBit(Action::Up)].x == 0.0f && g_directionTable[slotBit(Action::Up)].y == -1.0f);
+   CHECK(g_directionTable[slotBit(Action::DownLeft)].x == -h && g_directionTable[slotBit(Action::DownLeft)].y == h);
+   
+   // Chords and opposites
+   uint8_t upRight = slotBit(Action::Up) | slotBit(Action::Right);
+   CHECK(g_directionTable[upRight].x == h && g_directionTable[upRight].y == -h);
+   uint8_t upDown = slotBit(Action::Up) | slotBit(Action::Down);
+   CHECK(g_directionTable[upDown].x == 0.0f && g_directionTable[upDown].y == 0.0f);
+   uint8_t leftRightUp = slotBit(Action::Left) | slotBit(Action::Right) | slotBit(Action::Up);
+   CHECK(g_directionTable[leftRightUp].x == 0.0f && g_directionTable[leftRightUp].y == -1.0f);
+   
+   for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+      int o = g_oppositeSlot[s];
+      CHECK(o >= 0 && g_oppositeSlot[o] == s);
+      CHECK(std::fmod(DIRECTION_SLOTS[s].degrees + 180.0, 360.0) == DIRECTION_SLOTS[o].degrees);
+   }
+}
+
+// --- Axis lock and angle snap ---
+
+void testAngleSnap() {
+   // Single keys are already on 45 degree multiples; chords between them snap
+   for (int s = 0; s < DIRECTION_SLOT_COUNT; ++s) {
+      uint8_t bit = (uint8_t)(1u << s);
+      CHECK(g_snappedTable[bit].x == g_directionTable[bit].x && g_snappedTable[bit].y == g_directionTable[bit].y);
+   }
+   const float h = (float)std::sqrt(0.5);
+   uint8_t rightUpRight = slotBit(Action::Right) | slotBit(Action::UpRight); // 22.5 degrees, a tie: rounds up
+   CHECK(g_snappedTable[rightUpRight].x == h && g_snappedTable[rightUpRight].y == -h);
+   uint8_t upUpRight = slotBit(Action::Up) | slotBit(Action::UpRight);
+   CHECK(g_snappedTable[upUpRight].x == 0.0f && g_snappedTable[upUpRight].y == -1.0f); // 67.5 -> 90
+   
+   // Continuous vectors rotate onto the nearest multiple and keep their length
+   double x = 3.0, y = 1.0; // about 18 degrees off horizontal
+   snapVector(x, y);
+   CHECK_NEAR(x, std::sqrt(10.0), 1e-9);
+   CHECK(y == 0.0);
+   x = -2.0, y = 1.9;
+   snapVector(x, y);
+   CHECK_NEAR(x, -std::hypot(2.0, 1.9) * std::sqrt(0.5), 1e-9);
+   CHECK_NEAR(y, std::hypot(2.0, 1.9) * std::sqrt(0.5), 1e-9);
+   
+   // Already on a multiple (or zero): left bit-for-bit
+   x = 1234.567, y = -1234.567;
+   snapVector(x, y);
+   CHECK(x == 1234.567 && y == -1234.567);
+   x = 0.0, y = 0.0;
+   snapVector(x, y);
+   CHECK(x == 0.0 && y == 0.0);
+}
+
+void testAxisLock() {
+   PhysicsState st;
+   const DirectionVector &upRight = g_directionTable[slotBit(Action::Up) | slotBit(Action::Right)];
+   const DirectionVector &up = g_directionTable[slotBit(Action::Up)];
+   const DirectionVector &left = g_directionTable[slotBit(Action::Left)];
+   
+   // Nothing held yet: no axis chosen
+   axisLock(st, true);
+   CHECK(st.lockAxis == 0 && st.dx == 0.0f && st.dy == 0.0f);
+   
+   // A diagonal ties, and ties lock horizontal; the axis then stays put
+   st.dx = upRight.x;
+   st.dy = upRight.y;
+   st.vy = 300.0;
+   axisLock(st, true);
+   CHECK(st.lockAxis == 1 && st.dx == 1.0f && st.dy == 0.0f && st.vy == 0.0);
+   st.dx = up.x;
+   st.dy = up.y;
+   axisLock(st, true);
+   CHECK(st.dx == 0.0f && st.dy == 0.0f); // pure vertical input moves nowhere
+   st.dx = left.x;
+   st.dy = left.y;
+   axisLock(st, true);
+   CHECK(st.dx == -1.0f && st.dy == 0.0f);
+   
+   // Releasing the lock forgets the axis; the next motion picks again
+   axisLock(st, false);
+   CHECK(st.lockAxis == 0);
+   st.dx = up.x;
+   st.dy = up.y;
+   st.vx = 300.0;
+   axisLock(st, true);
+   CHECK(st.lockAxis == 2 && st.dx == 0.0f && st.dy == -1.0f && st.vx == 0.0);
+}
+
+// --- Click targets ---
+
+// Rows of the array of number arrays under "key" in a fixture file; just
+// enough JSON for test/fixtures, which holds nothing but such arrays
+std::vector<std::vector<double>> fixtureRows(const char *file, const char *key) {
+   std::ifstream in(std::string(MOUSEKEYS_FIXTURE_DIR) + "/" + file);
+   std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   std::vector<std::vector<double>> rows;
+   size_t at = text.find(std::string("\"") + key + "\"");
+   if (at == std::string::npos) return rows;
+   at = text.find('[', at) + 1;
+   int depth = 1;
+   for (const char *p = text.c_str() + at; *p && depth > 0;) {
+      if (*p == '[') {
+         ++depth;
+         rows.emplace_back();
+         ++p;
+      } else if (*p == ']') {
+         --depth;
+         ++p;
+      } else if (*p == '-' || (*p >= '0' && *p <= '9')) {
+         char *end;
+         rows.back().push_back(std::strtod(p, &end));
+         p = end;
+      } else {
+         ++p;
+      }
+   }
+   return rows;
+}
+
+void testTargetIndex() {
+   std::vector<std::vector<double>> rows = fixtureRows("targets.json", "rects");
+   std::vector<std::vector<double>> queries = fixtureRows("targets.json", "queries");
+   CHECK(rows.size() == 7 && queries.size() == 13);
+   std::vector<RECT> rects;
+   for (const std::vector<double> &row : rows) {
+      if (row.size() == 4) rects.push_back(RECT{ (LONG)row[0], (LONG)row[1], (LONG)row[2], (LONG)row[3] });
+   }
+   
+   TargetIndex index;
+   buildTargetIndex(index, rects);
+   CHECK(index.rects.size() == 5); // one too wide, one empty
+   CHECK(index.cellStart.size() == (size_t)index.cols * index.rows + 1 && index.cellStart.back() == index.rects.size());
+   
+   for (const std::vector<double> &q : queries) {
+      if (q.size() != 4) {
+         CHECK(q.size() == 4);
+         continue;
+      }
+      int hit = nearestTarget(index, q[0], q[1], q[2]);
+      int expected = (int)q[3];
+      bool ok = expected < 0 ? hit < 0
+         : hit >= 0 && std::memcmp(&index.rects[hit], &rects[expected], sizeof(RECT)) == 0;
+      if (!ok) {
+         char what[96];
+         std::snprintf(what, sizeof(what), "nearestTarget(%g, %g, %g) -> rect %d", q[0], q[1], q[2], expected);
+         fail(__FILE__, __LINE__, what);
+      }
+   }
+   
+   // The grid agrees with a linear scan everywhere (on distance; ties may pick either)
+   uint64_t rng = 0x5DEECE66Dull;
+   for (int i = 0; i < 20000; ++i) {
+      double x = (double)(soakRandom(rng) % 2200) - 100.0, y = (double)(soakRandom(rng) % 1300) - 100.0;
+      double radius = (double)(1 + soakRandom(rng) % 200);
+      double best = radius * radius;
+      bool found = false;
+      for (const RECT &r : index.rects) {
+         double ddx = (r.left + r.right) * 0.5 - x, ddy = (r.top + r.bottom) * 0.5 - y;
+         if (ddx * ddx + ddy * ddy <= best) {
+            best = ddx * ddx + ddy * ddy;
+            found = true;
+         }
+      }
+      int hit = nearestTarget(index, x, y, radius);
+      CHECK(found == (hit >= 0));
+      if (hit >= 0 && found) {
+         const RECT &r = index.rects[hit];
+         double ddx = (r.left + r.right) * 0.5 - x, ddy = (r.top + r.bottom) * 0.5 - y;
+         CHECK(ddx * ddx + ddy * ddy == best);
+      }
+   }
+   
+   // An empty index finds nothing
+   TargetIndex empty;
+   buildTargetIndex(empty, {});
+   CHECK(nearestTarget(empty, 960, 540, 1000) < 0);
+}
+
+// --- Hint labels ---
+
+// Rects in a row of cells, then their hint labels, published as the live set
+void makeHints(int count, TargetIndex &index, HintSet &set) {
+   std::vector<RECT> rects;
+   for (int i = 0; i < count; ++i) {
+      LONG x = (LONG)(i % 30) * TARGET_CELL_PX, y = (LONG)(i / 30) * TARGET_CELL_PX;
+      rects.push_back(RECT{ x + 10, y + 20, x + 50, y + 40 });
+   }
+   buildTargetIndex(index, rects);
+   buildHints(index, set);
+   g_targetOwned.hints.store(&set);
+}
+
+POINT warpedTo() {
+   uint64_t target = g_cursorRequests.warpTarget.load();
+   return POINT{ (int32_t)(uint32_t)(target >> 32), (int32_t)(uint32_t)target };
+}
+
+void testHintLabels() {
+   static TargetIndex index;
+   static HintSet set;
+   
+   // Two letters each, home row first, in the index's cell order, and unique
+   makeHints(40, index, set);
+   CHECK(set.count == 40);
+   CHECK(std::strcmp(set.labels[0], "aa") == 0 && std::strcmp(set.labels[1], "as") == 0);
+   CHECK(std::strcmp(set.labels[HINT_LETTERS], "sa") == 0);
+   for (int i = 0; i < set.count; ++i) {
+      CHECK(set.labels[i][0] == HINT_ALPHABET[i / HINT_LETTERS] && set.labels[i][1] == HINT_ALPHABET[i % HINT_LETTERS]);
+      CHECK(std::memcmp(&set.rects[i], &index.rects[index.cellItems[i]], sizeof(RECT)) == 0);
+      CHECK(std::strchr(set.labels[i], 'f') == nullptr); // 'F' cancels, so it is never a label letter
+   }
+   
+   // Prefix matching: the first letter picks a node, the second a target
+   g_hookOwned.hintNode = 0;
+   g_hookOwned.hintLastVk = 0;
+   g_hookOwned.hintClick = true;
+   g_hintMode.store(HINT_ACTIVE);
+   g_cursorRequests.warpPending.store(false);
+   sendKey('S', true);
+   CHECK(g_hookOwned.hintPrefix.load() == 1 && g_hintMode.load() == HINT_ACTIVE);
+   sendKey('S', true); // auto-repeat is not a second 's'
+   CHECK(!g_cursorRequests.warpPending.load());
+   sendKey('S', false);
+   sendKey('Y', true); // "sy" is not a label (only 15 start with 's'): ignored
+   sendKey('Y', false);
+   CHECK(!g_cursorRequests.warpPending.load() && g_hintMode.load() == HINT_ACTIVE);
+   sendKey('S', true); // "ss" is label 26
+   sendKey('S', false);
+   const RECT &r = set.rects[HINT_LETTERS + 1];
+   POINT at = warpedTo();
+   CHECK(g_cursorRequests.warpPending.load() && g_cursorRequests.warpClick.load());
+   CHECK(at.x == (r.left + r.right) / 2 && at.y == (r.top + r.bottom) / 2);
+   CHECK(g_hintMode.load() == HINT_OFF);
+   
+   // 'F' is not consumed (the hook's binding cancels), Escape is
+   g_hintMode.store(HINT_ACTIVE);
+   CHECK(!handleHintKey('F'));
+   CHECK(handleHintKey(VK_ESCAPE) && g_hintMode.load() == HINT_OFF);
+   
+   // Letters while still PENDING are swallowed but do nothing
+   g_hookOwned.hintNode = 0;
+   g_hookOwned.hintLastVk = 0;
+   g_hintMode.store(HINT_PENDING);
+   g_cursorRequests.warpPending.store(false);
+   CHECK(handleHintKey('A') && g_hookOwned.hintNode == 0);
+   cancelHints();
+   
+   // More targets than labels: the rest go unlabelled
+   makeHints(MAX_HINTS + 50, index, set);
+   CHECK(set.count == MAX_HINTS);
+   CHECK(std::strcmp(set.labels[MAX_HINTS - 1], "yy") == 0);
+   g_targetOwned.hints.store(&g_hintSlots[0]);
+   g_cursorRequests.warpPending.store(false);
+   g_cursorRequests.warpClick.store(false);
+}
+
+// --- Profiles ---
+
+void testFindProfile() {
+   const Profile *chrome = findProfile(L"chrome.exe");
+   CHECK(chrome != &DEFAULT_PROFILE && std::wcscmp(chrome->exeName, L"chrome.exe") == 0);
+   CHECK(findProfile(L"CHROME.EXE") == chrome && findProfile(L"Chrome.Exe") == chrome); // case-insensitive
+   CHECK(findProfile(L"windowsterminal.exe")->maxSpeed == 600.0f);
+   CHECK(findProfile(L"notepad.exe") == &DEFAULT_PROFILE);
+   CHECK(findProfile(L"chrome") == &DEFAULT_PROFILE); // whole names only
+   CHECK(findProfile(L"chrome.exe.bak") == &DEFAULT_PROFILE);
+   CHECK(findProfile(L"") == &DEFAULT_PROFILE);
+   
+   // Every profile has its own runtime slot
+   CHECK(profileIndex(&DEFAULT_PROFILE) == 0);
+   for (int i = 0; i < PROFILE_COUNT - 1; ++i) CHECK(profileIndex(findProfile(PROFILES[i].exeName)) == i + 1);
+   compileProfileCurves();
+   CHECK(g_curves[profileIndex(chrome)].valid && !g_curves[0].valid);
+   
+   // Through the window's process image path, either separator
+   shimProcessImage = L"C:\\Program Files\\Google\\Chrome\\Application\\chrome.exe";
+   CHECK(profileForWindow((HWND)1) == chrome);
+   shimProcessImage = L"D:/tools/Blender.exe";
+   CHECK(std::wcscmp(profileForWindow((HWND)1)->exeName, L"blender.exe") == 0);
+   shimProcessImage = L"C:\\chrome.exe\\notepad.exe";
+   CHECK(profileForWindow((HWND)1) == &DEFAULT_PROFILE);
+   shimProcessImage = nullptr;
+   CHECK(profileForWindow((HWND)1) == &DEFAULT_PROFILE);
+   CHECK(profileForWindow(nullptr) == &DEFAULT_PROFILE);
+}
+
+// --- HUD (drawn offscreen into the GL shim's recorder) ---
+
+// Text lines of the last frame, top to bottom
+std::vector<std::string> hudLines() {
+   std::vector<std::string> lines;
+   for (const ShimGlFrame::Text &t : shimGl.texts) lines.push_back(t.text);
+   return lines;
+}
+
+void testRenderHud() {
+   Hud hud;
+   hud.hwnd = (HWND)&hud;
+   
+   renderHud(hud, 0);
+   CHECK(shimGl.cleared && shimGl.clear[3] == 1.0f);
+   CHECK(hudLines() == std::vector<std::string>{ "MOUSEKEYS  OFF" });
+   CHECK(shimGl.quads.size() == 1);
+   const ShimGlFrame::Quad &offBar = shimGl.quads[0];
+   CHECK(offBar.left == 0 && offBar.top == 0 && offBar.right == 6 && offBar.bottom == HUD_HEIGHT);
+   CHECK(offBar.color.r == offBar.color.g); // grey while off
+   
+   renderHud(hud, HUD_ENABLED);
+   CHECK(hudLines() == (std::vector<std::string>{ "MOUSEKEYS  ON", "fast   drag -" }));
+   CHECK(shimGl.quads.size() == 1 && shimGl.quads[0].color.g > shimGl.quads[0].color.r); // green while on
+   
+   renderHud(hud, HUD_ENABLED | HUD_SLOW | HUD_LEFT_HELD);
+   CHECK(hudLines()[1] == "slow   drag L");
+   renderHud(hud, HUD_ENABLED | HUD_LEFT_HELD | HUD_RIGHT_HELD);
+   CHECK(hudLines()[1] == "fast   drag LR");
+   renderHud(hud, HUD_SLOW | HUD_RIGHT_HELD); // off: nothing but the title
+   CHECK(hudLines().size() == 1);
+   
+   // Every line fits the HUD
+   for (const ShimGlFrame::Text &t : shimGl.texts) CHECK(t.x >= 0 && t.y > 0 && t.y < HUD_HEIGHT);
+   
+   // Presented in the top-right corner of the work area, at HUD_OPACITY
+   CHECK(shimLastLayered.hwnd == hud.hwnd);
+   CHECK(shimLastLayered.dst.x == 1920 - HUD_WIDTH - 12 && shimLastLayered.dst.y == 12);
+   CHECK(shimLastLayered.size.cx == HUD_WIDTH && shimLastLayered.size.cy == HUD_HEIGHT);
+   CHECK(shimLastLayered.alpha == HUD_OPACITY);
+}
+
+// --- Magnifier lens (captures the shim's test screen) ---
+
+// Every screen pixel distinct: x in the high bits, y in the low
+uint32_t screenPixel(int x, int y) {
+   return 0xFF000000u | (uint32_t)x << 12 | (uint32_t)y;
+}
+
+// The lens shows the cursor's tile: LENS_TILE x LENS_TILE screen pixels
+// centred on it, each a LENS_ZOOM block, under the hotspot outline
+void checkLensTile(const Lens &lens, POINT cursor) {
+   int c0 = (LENS_TILE / 2) * LENS_ZOOM - 1, c1 = c0 + LENS_ZOOM + 1;
+   int wrong = 0;
+   for (int y = 0; y < LENS_SIZE; ++y) {
+      for (int x = 0; x < LENS_SIZE; ++x) {
+         bool outline = ((y == c0 || y == c1) && x >= c0 && x <= c1) || ((x == c0 || x == c1) && y >= c0 && y <= c1);
+         int sx = cursor.x - LENS_TILE / 2 + x / LENS_ZOOM, sy = cursor.y - LENS_TILE / 2 + y / LENS_ZOOM;
+         bool onScreen = sx >= 0 && sy >= 0 && sx < shimScreen.width && sy < shimScreen.height;
+         uint32_t expected = outline ? 0xFFFF3030 : onScreen ? screenPixel(sx, sy) : 0;
+         wrong += lens.pixels[y * LENS_SIZE + x] != expected;
+      }
+   }
+   CHECK(wrong == 0);
+}
+
+// Straight per-channel bilinear, to hold the SSE2 kernels to
+uint32_t lerpReference(uint32_t a, uint32_t b, uint32_t w) {
+   uint32_t r = 0;
+   for (int shift = 0; shift < 32; shift += 8) {
+      r |= ((((a >> shift) & 0xFF) * (256 - w) + ((b >> shift) & 0xFF) * w) >> 8) << shift;
+   }
+   return r;
+}
+
+void testLens() {
+   shimScreen.width = 1920;
+   shimScreen.height = 1080;
+   shimScreen.pixels.resize((size_t)shimScreen.width * shimScreen.height);
+   for (int y = 0; y < shimScreen.height; ++y) {
+      for (int x = 0; x < shimScreen.width; ++x) shimScreen.pixels[(size_t)y * shimScreen.width + x] = screenPixel(x, y);
+   }
+   Lens lens;
+   lens.hwnd = (HWND)&lens;
+   CHECK(createDibDc(LENS_SOURCE, LENS_SOURCE, lens.captureDc, lens.captureBitmap, lens.capture)
+      && createDibDc(LENS_SIZE, LENS_SIZE, lens.lensDc, lens.lensBitmap, lens.pixels));
+   
+   // Hidden unless the lens is on and precision mode is held
+   g_control.lensOn.store(true);
+   g_snapshot.publish({ 0, 0.0, 0.0, 0.0f, 0.0f, HUD_ENABLED });
+   CHECK(!updateLens(lens) && !lens.shown);
+   
+   g_snapshot.publish({ 0, 0.0, 0.0, 0.0f, 0.0f, HUD_ENABLED | HUD_SLOW });
+   shimCursor = { 500, 300 };
+   CHECK(!updateLens(lens) && lens.shown);
+   checkLensTile(lens, shimCursor);
+   CHECK(shimLastLayered.hwnd == lens.hwnd && shimLastLayered.dst.x == 524 && shimLastLayered.dst.y == 324);
+   CHECK(shimLastLayered.size.cx == LENS_SIZE && shimLastLayered.alpha == 255);
+   
+   // Same pixel: nothing captured. Moved within the rate cap: pending
+   lens.pixels[0] = 0;
+   CHECK(!updateLens(lens) && lens.pixels[0] == 0);
+   shimCursor = { 501, 300 };
+   lens.lastCapture = qpcNow();
+   CHECK(updateLens(lens));
+   
+   // Near the bottom-right corner: off-screen pixels are black and the lens flips to the cursor's other side
+   lens.lastCapture = 0;
+   shimCursor = { 1910, 1075 };
+   CHECK(!updateLens(lens));
+   checkLensTile(lens, shimCursor);
+   CHECK(shimLastLayered.dst.x == 1910 - 24 - LENS_SIZE && shimLastLayered.dst.y == 1075 - 24 - LENS_SIZE);
+   
+   // Bilinear against a per-channel reference, on the last capture
+   std::vector<uint32_t> smooth((size_t)LENS_SIZE * LENS_SIZE);
+   shimCursor = { 700, 700 };
+   lens.lastCapture = 0;
+   updateLens(lens);
+   scaleBilinear(lens.capture, LENS_SOURCE, smooth.data());
+   int wrong = 0;
+   for (int y = 0; y < LENS_SIZE; ++y) {
+      for (int x = 0; x < LENS_SIZE; ++x) {
+         const uint32_t *s = lens.capture + (y / LENS_ZOOM) * LENS_SOURCE + x / LENS_ZOOM;
+         uint32_t wx = lensWeight(x % LENS_ZOOM), wy = lensWeight(y % LENS_ZOOM);
+         uint32_t expected = lerpReference(lerpReference(s[0], s[1], wx), lerpReference(s[LENS_SOURCE], s[LENS_SOURCE + 1], wx), wy);
+         wrong += smooth[(size_t)y * LENS_SIZE + x] != expected;
+      }
+   }
+   CHECK(wrong == 0);
+   
+   // Letting go of precision mode hides it
+   g_snapshot.publish({ 0, 0.0, 0.0, 0.0f, 0.0f, HUD_ENABLED });
+   CHECK(!updateLens(lens) && !lens.shown);
+   lens.hwnd = nullptr;
+   destroyLens(lens);
+   g_control.lensOn.store(SHOW_LENS);
+   shimScreen = ShimScreen();
+   CHECK(shimBitmaps.empty());
+}
+
+// --- Soak ---
+
+constexpr double SOAK_TEST_HOURS = 2.0; // virtual: 12 drift probes, well under a second
+
+// A short run of the soak simulator (see runSoak): random key traffic with
+// drift probes, checked for stuck buttons, desyncs, bounds and drift
+void testSoak() {
+   clearHeldKeys();
+   g_keyEvents.drain(nullptr, KEY_EVENT_RING_SIZE);
+   g_control.enabled.store(false);
+   g_control.magnetOn.store(false);
+   g_soak = SoakDesktop();
+   uint64_t toggles = g_stats.toggles.load();
+   CHECK(runSoak(SOAK_TEST_HOURS) == 0);
+   CHECK(g_stats.toggles.load() > toggles + 10); // it really did turn control on and off
+   CHECK(!g_control.enabled.load() && !g_soak.buttons[0] && !g_soak.buttons[1]);
+}
+
+struct TestCase {
+   const char *name;
+   void (*run)();
+};
+
+const TestCase TESTS[] = {
+   { "curve_precedence", testCurvePrecedence },
+   { "curve_errors", testCurveErrors },
+   { "curve_clamp", testCurveClamp },
+   { "socd_policies", testSocdPolicies },
+   { "glide_flick", testGlideFlick },
+   { "resync_from_cursor", testResyncFromCursor },
+   { "count_nudge", testCountNudge },
+   { "mul_fixed", testMulFixed },
+   { "fixed_trajectory", testFixedTrajectory },
+   { "direction_table", testDirectionTable },
+   { "angle_snap", testAngleSnap },
+   { "axis_lock", testAxisLock },
+   { "target_index", testTargetIndex },
+   { "hint_labels", testHintLabels },
+   { "find_profile", testFindProfile },
+   { "render_hud", testRenderHud },
+   { "lens", testLens },
+   { "soak", testSoak },
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+   LARGE_INTEGER frequency;
+   QueryPerformanceFrequency(&frequency);
+   g_qpcFrequency = frequency.QuadPart;
+   buildDirectionTable();
+
+   int run = 0;
+   for (const TestCase &test : TESTS) {
+      bool selected = argc == 1;
+      for (int i = 1; i < argc; ++i) selected = selected || std::strcmp(argv[i], test.name) == 0;
+      if (!selected) continue;
+      int before = g_failures;
+      test.run();
+      std::printf("%-24s %s\n", test.name, g_failures == before ? "ok" : "FAILED");
+      ++run;
+   }
+   if (run == 0) {
+      std::fprintf(stderr, "no such case\n");
+      return 1;
+   }
+   return g_failures ? 1 : 0;
+}